@@ -1,10 +1,14 @@
 #include "udp-reliable-helper.h"
+#include "udp-reliable-echo-client.h"
+#include "reliable-congestion-ops.h"
+#include "reliable-metrics.h"
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
 
 //custom
 
@@ -12,10 +16,77 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("assn2");
 
+static uint64_t tcpBulkBytes = 0; //!< bytes the TCP comparison flow has to deliver
+static uint64_t tcpReceived = 0; //!< bytes the TCP comparison flow has delivered
+static Time tcpFirstByte; //!< arrival of the first TCP byte
+
+static void
+TcpSinkRx (Ptr<const Packet> packet, const Address &/* from */)
+{
+    if (tcpReceived == 0) {
+        tcpFirstByte = Simulator::Now();
+    }
+    uint64_t before = tcpReceived;
+    tcpReceived += packet->GetSize();
+    if (before < tcpBulkBytes && tcpReceived >= tcpBulkBytes) {
+        Time fct = Simulator::Now() - Seconds(1.0);
+        NS_LOG_INFO("TCP Flow Completion Time:" << fct.GetSeconds() << "s"
+                    << " Time To First Byte:" << (tcpFirstByte - Seconds(1.0)).GetSeconds() << "s"
+                    << " Goodput:" << (tcpBulkBytes * 8 / fct.GetSeconds() / 1e6) << "Mbps");
+    }
+}
+
+static uint32_t holMessages = 0; //!< messages delivered in order by the server
+static Time holTotal; //!< head-of-line blocking summed over them
+static Time holMax; //!< largest head-of-line blocking
+
+static void
+ServerHolBlocking (uint16_t /* stream */, Time delay)
+{
+    holMessages++;
+    holTotal += delay;
+    if (delay > holMax) {
+        holMax = delay;
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
     LogComponentEnable("UdpReliableEchoClientApplication", LOG_LEVEL_INFO);
+    LogComponentEnable("assn2", LOG_LEVEL_INFO);
+
+    std::string cc = "Aimd";
+    std::string ackMode = "Echo";
+    uint32_t ackEvery = 2;
+    double ackDelay = 5;
+    std::string lossDetection = "Time";
+    std::string metricsFile = "";
+    bool metricsBinary = false;
+    uint64_t bulkBytes = 0;
+    bool tcp = false;
+    uint32_t messageSize = 1024;
+    uint32_t mss = 1400;
+    double urgent = 0;
+    uint32_t urgentSize = 100;
+    bool ecn = false;
+
+    CommandLine cmd;
+    cmd.AddValue ("cc", "Client congestion control (None, Aimd or DelayBased)", cc);
+    cmd.AddValue ("ack", "Server acknowledgements (Echo or Sack)", ackMode);
+    cmd.AddValue ("ackEvery", "In-order packets covered by one server ACK", ackEvery);
+    cmd.AddValue ("ackDelay", "Server delayed ACK timer in ms (0 to ACK every packet)", ackDelay);
+    cmd.AddValue ("loss", "Client loss detection (Packet or Time)", lossDetection);
+    cmd.AddValue ("metrics", "File the client metrics are written to (empty for none)", metricsFile);
+    cmd.AddValue ("metricsBinary", "Write the metrics as binary records instead of CSV", metricsBinary);
+    cmd.AddValue ("bulk", "Bytes of a bulk transfer replacing the periodic client (0 for none)", bulkBytes);
+    cmd.AddValue ("tcp", "Run the bulk transfer over TCP instead, for comparison", tcp);
+    cmd.AddValue ("size", "Client message size in bytes", messageSize);
+    cmd.AddValue ("mss", "Largest client payload per packet; larger messages are fragmented", mss);
+    cmd.AddValue ("urgent", "Interval in ms of a second, high-priority client stream (0 for none)", urgent);
+    cmd.AddValue ("urgentSize", "Message size of the high-priority stream", urgentSize);
+    cmd.AddValue ("ecn", "ECN-marking RED queue at the router bottleneck, ECN on client and server", ecn);
+    cmd.Parse (argc, argv);
 
       Ptr<Node> nSrc1 = CreateObject<Node> ();
       Ptr<Node> nSrc2 = CreateObject<Node> ();
@@ -40,6 +111,20 @@ main (int argc, char *argv[])
       NetDeviceContainer dSrc2dRtr = p2p.Install (nSrc2nRtr);
       NetDeviceContainer dRtrdDst  = p2p.Install (nRtrnDst);
 
+      if (ecn) {
+          // mark instead of drop at the bottleneck; installed before the
+          // addresses are assigned, which would add the default queue disc
+          TrafficControlHelper tch;
+          tch.SetRootQueueDisc ("ns3::RedQueueDisc",
+                                "UseEcn", BooleanValue (true),
+                                "MaxSize", StringValue ("25p"),
+                                "MinTh", DoubleValue (5),
+                                "MaxTh", DoubleValue (15),
+                                "LinkBandwidth", StringValue ("1Mbps"),
+                                "LinkDelay", StringValue ("5ms"));
+          tch.Install (dRtrdDst.Get(0));
+      }
+
       // Add IP addresses
       Ipv4AddressHelper ipv4;
       ipv4.SetBase ("10.1.1.0", "255.255.255.0");
@@ -57,16 +142,64 @@ main (int argc, char *argv[])
     UdpReliableEchoClientHelper echoClient(iRtriDst.GetAddress(1), udp_port);
     echoClient.SetAttribute("MaxPackets", UintegerValue(1000000));
     echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-    echoClient.SetAttribute("PacketSize", UintegerValue(1024));
+    echoClient.SetAttribute("PacketSize", UintegerValue(messageSize));
+    echoClient.SetAttribute("MaxSegmentSize", UintegerValue(mss));
+    echoClient.SetAttribute("AckMode", StringValue(ackMode));
+    echoClient.SetAttribute("LossDetection", StringValue(lossDetection));
+    echoClient.SetAttribute("BulkBytes", UintegerValue(bulkBytes));
+    echoClient.SetAttribute("Ecn", BooleanValue(ecn));
+    // with an urgent stream, the main stream only gets what it leaves
+    echoClient.SetAttribute("Priority", UintegerValue(urgent > 0 ? 1 : 0));
+    if (cc == "None")
+      {
+        // fixed Interval, as before congestion control
+        echoClient.SetAttribute("CongestionControl", TypeIdValue(ReliableCongestionOps::GetTypeId()));
+      }
+    else
+      {
+        echoClient.SetAttribute("CongestionControl", TypeIdValue(TypeId::LookupByName("ns3::Reliable" + cc)));
+      }
 
     ApplicationContainer app2;
-    app2.Add(echoClient.Install(nSrc1));
+    if (tcp && bulkBytes > 0) {
+        // same bytes, same path, over TCP
+        uint16_t tcp_port = 11;
+        BulkSendHelper bulkSend ("ns3::TcpSocketFactory",
+                                 Address (InetSocketAddress (iRtriDst.GetAddress(1), tcp_port)));
+        bulkSend.SetAttribute("MaxBytes", UintegerValue(bulkBytes));
+        app2.Add(bulkSend.Install(nSrc1));
+
+        PacketSinkHelper tcpSink ("ns3::TcpSocketFactory",
+                                  Address (InetSocketAddress (Ipv4Address::GetAny (), tcp_port)));
+        ApplicationContainer tcpSinkApp = tcpSink.Install (nDst);
+        tcpSinkApp.Start (Seconds (0.0));
+        tcpSinkApp.Stop (Seconds (31.0));
+        tcpBulkBytes = bulkBytes;
+        tcpSinkApp.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&TcpSinkRx));
+    } else {
+        app2.Add(echoClient.Install(nSrc1));
+        if (urgent > 0) {
+            DynamicCast<UdpReliableEchoClient>(app2.Get(0))->AddStream(urgentSize, Seconds(urgent / 1000.0), 0);
+        }
+    }
     app2.Start(Seconds(1.0));
+
+    ReliableMetricsSink metricsSink;
+    if (!metricsFile.empty() && !(tcp && bulkBytes > 0)
+        && metricsSink.Open(metricsFile, metricsBinary ? ReliableMetricsSink::BINARY : ReliableMetricsSink::CSV))
+      {
+        app2.Get(0)->TraceConnectWithoutContext("Metrics", MakeCallback(&ReliableMetricsSink::Write, &metricsSink));
+      }
     app2.Stop(Seconds(30.0));
 
     UdpReliableEchoServerHelper echoServer(udp_port);
+    echoServer.SetAttribute("AckMode", StringValue(ackMode));
+    echoServer.SetAttribute("AckEvery", UintegerValue(ackEvery));
+    echoServer.SetAttribute("AckDelay", TimeValue(Seconds(ackDelay / 1000.0)));
+    echoServer.SetAttribute("Ecn", BooleanValue(ecn));
     ApplicationContainer app3;
     app3.Add(echoServer.Install(nDst));
+    app3.Get(0)->TraceConnectWithoutContext("HolBlocking", MakeCallback(&ServerHolBlocking));
     app3.Start(Seconds(0.0));
     app3.Stop(Seconds(31.0));
 
@@ -93,6 +226,11 @@ main (int argc, char *argv[])
 //    p2p.EnablePcapAll("assn2");
 
     Simulator::Run ();
+    if (holMessages > 0) {
+        NS_LOG_INFO("Messages delivered in order:" << holMessages
+                    << " Mean HOL blocking:" << (holTotal / holMessages).GetMilliSeconds() << "ms"
+                    << " Max HOL blocking:" << holMax.GetMilliSeconds() << "ms");
+    }
     Simulator::Stop(Seconds(33.0));
     Simulator::Destroy ();
     return 0;
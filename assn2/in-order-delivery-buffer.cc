@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "in-order-delivery-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("InOrderDeliveryBuffer");
+
+InOrderDeliveryBuffer::InOrderDeliveryBuffer ()
+  : m_next (0),
+    m_bytes (0),
+    m_maxBytes (0),
+    m_skipped (0)
+{
+}
+
+void
+InOrderDeliveryBuffer::Init (uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxBytes);
+  m_messages.clear ();
+  m_next = 0;
+  m_bytes = 0;
+  m_maxBytes = maxBytes;
+  m_skipped = 0;
+}
+
+bool
+InOrderDeliveryBuffer::Insert (uint32_t message, Ptr<const Packet> data, Time arrival)
+{
+  NS_LOG_FUNCTION (this << message << arrival);
+  if (static_cast<int32_t> (message - m_next) < 0)
+    {
+      NS_LOG_LOGIC ("Message " << message << " already delivered or given up");
+      return false;
+    }
+  Message entry;
+  entry.message = message;
+  entry.data = data;
+  entry.arrival = arrival;
+  if (!m_messages.insert (std::make_pair (message, entry)).second)
+    {
+      return false;
+    }
+  m_bytes += data->GetSize ();
+  return true;
+}
+
+bool
+InOrderDeliveryBuffer::Pop (Message &message)
+{
+  if (m_messages.empty ())
+    {
+      return false;
+    }
+  std::map<uint32_t, Message>::iterator it = m_messages.begin ();
+  if (it->first != m_next)
+    {
+      if (m_bytes <= m_maxBytes)
+        {
+          // wait for the missing message
+          return false;
+        }
+      NS_LOG_LOGIC ("Over budget: giving up messages " << m_next << " to " << it->first - 1);
+      m_skipped += it->first - m_next;
+    }
+  message = it->second;
+  m_bytes -= message.data->GetSize ();
+  m_next = it->first + 1;
+  m_messages.erase (it);
+  return true;
+}
+
+uint32_t
+InOrderDeliveryBuffer::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+uint32_t
+InOrderDeliveryBuffer::GetSkipped (void) const
+{
+  return m_skipped;
+}
+
+} // namespace ns3
@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IN_ORDER_DELIVERY_BUFFER_H
+#define IN_ORDER_DELIVERY_BUFFER_H
+
+#include <stdint.h>
+#include <map>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup udpecho
+ * \brief Reorder buffer releasing the messages of one stream in order
+ *
+ * Messages are inserted as they complete, in any order, and popped in
+ * message-number order.  A message that completes before an earlier one
+ * waits here; the time it waits is the head-of-line blocking the
+ * reliability costs the application.  The buffer holds at most MaxBytes
+ * of payload: beyond that the missing messages are given up and delivery
+ * resumes with the oldest one held, so a message the sender abandoned
+ * cannot stall the stream for good.
+ */
+class InOrderDeliveryBuffer
+{
+public:
+  /// A message leaving the buffer
+  struct Message
+  {
+    uint32_t message; //!< message number
+    Ptr<const Packet> data; //!< message payload
+    Time arrival; //!< time the message completed
+  };
+
+  InOrderDeliveryBuffer ();
+
+  /**
+   * \brief Drop any held message and restart at message 0.
+   * \param maxBytes payload bytes the buffer may hold
+   */
+  void Init (uint32_t maxBytes);
+
+  /**
+   * \brief Hold a complete message until the ones before it are popped.
+   * \param message message number
+   * \param data message payload
+   * \param arrival time the message completed
+   * \returns false if the message was already delivered, given up or held
+   */
+  bool Insert (uint32_t message, Ptr<const Packet> data, Time arrival);
+
+  /**
+   * \brief Take the next message in order.
+   *
+   * Missing messages are given up if the buffer is over its budget.
+   *
+   * \param [out] message the message
+   * \returns false if the next message has not arrived yet
+   */
+  bool Pop (Message &message);
+
+  /// \returns payload bytes held
+  uint32_t GetBytes (void) const;
+  /// \returns messages given up because the buffer was over its budget
+  uint32_t GetSkipped (void) const;
+
+private:
+  std::map<uint32_t, Message> m_messages; //!< held messages, by number
+  uint32_t m_next; //!< next message to deliver
+  uint32_t m_bytes; //!< payload bytes held
+  uint32_t m_maxBytes; //!< payload bytes the buffer may hold
+  uint32_t m_skipped; //!< messages given up
+};
+
+} // namespace ns3
+
+#endif /* IN_ORDER_DELIVERY_BUFFER_H */
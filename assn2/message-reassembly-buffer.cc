@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "reliable-data-header.h"
+#include "message-reassembly-buffer.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MessageReassemblyBuffer");
+
+MessageReassemblyBuffer::MessageReassemblyBuffer ()
+  : m_maxMessageSize (0),
+    m_evicted (0)
+{
+}
+
+void
+MessageReassemblyBuffer::Init (uint32_t slots, uint32_t maxMessageSize)
+{
+  NS_LOG_FUNCTION (this << slots << maxMessageSize);
+  NS_ASSERT_MSG (slots > 0, "MessageReassemblyBuffer::Init(): no slot");
+  Slot empty = { 0, 0, 0, 0, FREE };
+  m_slots.assign (slots, empty);
+  m_data.assign (static_cast<size_t> (slots) * maxMessageSize, 0);
+  m_maxMessageSize = maxMessageSize;
+  m_evicted = 0;
+}
+
+bool
+MessageReassemblyBuffer::IsInit (void) const
+{
+  return !m_slots.empty ();
+}
+
+MessageReassemblyBuffer::InsertResult
+MessageReassemblyBuffer::Insert (uint32_t message, uint16_t fragment, uint16_t fragments,
+                                 uint32_t offset, Ptr<const Packet> data)
+{
+  NS_LOG_FUNCTION (this << message << fragment << fragments << offset);
+  uint32_t index = message % m_slots.size ();
+  Slot &slot = m_slots[index];
+  if (slot.state != FREE && slot.message != message)
+    {
+      if (static_cast<int32_t> (message - slot.message) < 0)
+        {
+          return STALE;
+        }
+      if (slot.state == ASSEMBLING)
+        {
+          NS_LOG_LOGIC ("Evicting message " << slot.message << " with "
+                        << slot.received << "/" << slot.fragments << " fragments");
+          m_evicted++;
+        }
+      slot.state = FREE;
+    }
+  if (slot.state == FREE)
+    {
+      slot.message = message;
+      slot.fragments = fragments;
+      slot.received = 0;
+      slot.bitmap = 0;
+      slot.state = ASSEMBLING;
+    }
+  if (slot.state == DONE || fragment >= ReliableDataHeader::MAX_FRAGMENTS
+      || (slot.bitmap >> fragment) & 1)
+    {
+      return DUPLICATE;
+    }
+
+  uint32_t size = data->GetSize ();
+  if (offset < m_maxMessageSize)
+    {
+      // bytes past MaxMessageSize are counted but not kept
+      uint32_t kept = std::min (size, m_maxMessageSize - offset);
+      data->CopyData (&m_data[static_cast<size_t> (index) * m_maxMessageSize + offset], kept);
+    }
+  slot.bitmap |= uint64_t (1) << fragment;
+  if (++slot.received < slot.fragments)
+    {
+      return PARTIAL;
+    }
+  slot.state = DONE;
+  return COMPLETE;
+}
+
+const uint8_t *
+MessageReassemblyBuffer::GetData (uint32_t message) const
+{
+  if (m_slots.empty ())
+    {
+      return 0;
+    }
+  uint32_t index = message % m_slots.size ();
+  if (m_slots[index].state == FREE || m_slots[index].message != message)
+    {
+      return 0;
+    }
+  return &m_data[static_cast<size_t> (index) * m_maxMessageSize];
+}
+
+uint32_t
+MessageReassemblyBuffer::GetEvicted (void) const
+{
+  return m_evicted;
+}
+
+} // namespace ns3
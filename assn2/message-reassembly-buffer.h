@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MESSAGE_REASSEMBLY_BUFFER_H
+#define MESSAGE_REASSEMBLY_BUFFER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup udpecho
+ * \brief Fixed ring of preallocated buffers reassembling fragmented messages
+ *
+ * Message m is assembled in slot m % slots, whose buffer of MaxMessageSize
+ * bytes is allocated once by Init; fragments are copied in at their
+ * offset and a bitmap records which have arrived, so no memory is
+ * allocated per message.  A newer message taking the slot of an
+ * incomplete one evicts it.  A completed message keeps its slot until a
+ * newer message needs it, so late duplicates of its fragments are
+ * recognized.
+ */
+class MessageReassemblyBuffer
+{
+public:
+  /// Outcome of inserting one fragment
+  enum InsertResult
+  {
+    STALE,      //!< message older than the one owning the slot
+    DUPLICATE,  //!< fragment already received, or its message already complete
+    PARTIAL,    //!< fragment stored, message still incomplete
+    COMPLETE    //!< fragment stored and the message is whole
+  };
+
+  MessageReassemblyBuffer ();
+
+  /**
+   * \brief Allocate the ring, dropping any state it held.
+   * \param slots number of messages assembled at once
+   * \param maxMessageSize bytes of the largest message
+   */
+  void Init (uint32_t slots, uint32_t maxMessageSize);
+
+  /// \returns true once Init has allocated the ring
+  bool IsInit (void) const;
+
+  /**
+   * \brief Store one fragment.
+   * \param message message number
+   * \param fragment index of the fragment
+   * \param fragments number of fragments in the message
+   * \param offset position of the fragment in the message
+   * \param data the fragment payload
+   * \returns what happened to the fragment
+   */
+  InsertResult Insert (uint32_t message, uint16_t fragment, uint16_t fragments,
+                       uint32_t offset, Ptr<const Packet> data);
+
+  /**
+   * \param message message number
+   * \returns the bytes of a message held in the ring, or a null pointer
+   */
+  const uint8_t *GetData (uint32_t message) const;
+
+  /// \returns incomplete messages evicted by newer ones
+  uint32_t GetEvicted (void) const;
+
+private:
+  /// Slot life cycle
+  enum State
+  {
+    FREE,        //!< never used
+    ASSEMBLING,  //!< message being received
+    DONE         //!< message complete, slot kept to filter late fragments
+  };
+
+  /// Per-message metadata
+  struct Slot
+  {
+    uint32_t message;   //!< message owning the slot
+    uint16_t fragments; //!< fragments in the message
+    uint16_t received;  //!< fragments received
+    uint64_t bitmap;    //!< bit i: fragment i received
+    State state;        //!< slot life cycle
+  };
+
+  std::vector<Slot> m_slots;   //!< ring of slots
+  std::vector<uint8_t> m_data; //!< m_maxMessageSize bytes per slot
+  uint32_t m_maxMessageSize;   //!< bytes of the largest message
+  uint32_t m_evicted;          //!< incomplete messages evicted
+};
+
+} // namespace ns3
+
+#endif /* MESSAGE_REASSEMBLY_BUFFER_H */
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "reliable-ack-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReliableAckHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (ReliableAckHeader);
+
+ReliableAckHeader::ReliableAckHeader ()
+  : m_seq (0),
+    m_ts (0),
+    m_cumAck (0),
+    m_sack (0),
+    m_ceCount (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReliableAckHeader::SetSeq (uint32_t seq)
+{
+  m_seq = seq;
+}
+
+uint32_t
+ReliableAckHeader::GetSeq (void) const
+{
+  return m_seq;
+}
+
+void
+ReliableAckHeader::SetTs (Time ts)
+{
+  m_ts = ts.GetTimeStep ();
+}
+
+Time
+ReliableAckHeader::GetTs (void) const
+{
+  return TimeStep (m_ts);
+}
+
+void
+ReliableAckHeader::SetCumulativeAck (uint32_t ack)
+{
+  m_cumAck = ack;
+}
+
+uint32_t
+ReliableAckHeader::GetCumulativeAck (void) const
+{
+  return m_cumAck;
+}
+
+void
+ReliableAckHeader::SetSack (uint64_t sack)
+{
+  m_sack = sack;
+}
+
+uint64_t
+ReliableAckHeader::GetSack (void) const
+{
+  return m_sack;
+}
+
+void
+ReliableAckHeader::SetCeCount (uint32_t count)
+{
+  m_ceCount = count;
+}
+
+uint32_t
+ReliableAckHeader::GetCeCount (void) const
+{
+  return m_ceCount;
+}
+
+bool
+ReliableAckHeader::IsAcked (uint32_t seq) const
+{
+  int32_t distance = static_cast<int32_t> (seq - m_cumAck);
+  if (distance <= 0)
+    {
+      return distance < 0;
+    }
+  uint32_t bit = distance - 1;
+  return bit < SACK_BITS && ((m_sack >> bit) & 1);
+}
+
+TypeId
+ReliableAckHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReliableAckHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ReliableAckHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ReliableAckHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ReliableAckHeader::Print (std::ostream &os) const
+{
+  os << "(seq=" << m_seq << " time=" << TimeStep (m_ts).GetSeconds ()
+     << " cum=" << m_cumAck << " sack=0x" << std::hex << m_sack << std::dec
+     << " ce=" << m_ceCount << ")";
+}
+
+uint32_t
+ReliableAckHeader::GetSerializedSize (void) const
+{
+  return 4 + 8 + 4 + 8 + 4;
+}
+
+void
+ReliableAckHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_seq);
+  i.WriteHtonU64 (m_ts);
+  i.WriteHtonU32 (m_cumAck);
+  i.WriteHtonU64 (m_sack);
+  i.WriteHtonU32 (m_ceCount);
+}
+
+uint32_t
+ReliableAckHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_seq = i.ReadNtohU32 ();
+  m_ts = i.ReadNtohU64 ();
+  m_cumAck = i.ReadNtohU32 ();
+  m_sack = i.ReadNtohU64 ();
+  m_ceCount = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
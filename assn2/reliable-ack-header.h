@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RELIABLE_ACK_HEADER_H
+#define RELIABLE_ACK_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/// How UdpReliableEchoServer acknowledges the packets it receives
+enum ReliableAckMode
+{
+  ACK_ECHO,  //!< every packet is echoed back whole
+  ACK_SACK   //!< a ReliableAckHeader is returned instead
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Cumulative and selective acknowledgement of UdpReliableEchoServer
+ *
+ * Every sequence number below the cumulative ACK has been received, the
+ * cumulative ACK itself has not, and bit i of the SACK bitmap tells
+ * whether cumulative ACK + 1 + i has.  The header also returns the
+ * sequence number and SeqTsHeader timestamp of the packet that triggered
+ * it, for round-trip time sampling, and the number of packets that
+ * arrived with an ECN Congestion Experienced mark.  The count covers the
+ * whole session rather than one ACK, so a lost ACK loses no mark.
+ */
+class ReliableAckHeader : public Header
+{
+public:
+  /// Sequence numbers covered by the SACK bitmap
+  static const uint32_t SACK_BITS = 64;
+
+  ReliableAckHeader ();
+
+  /// \param seq the sequence number of the packet acknowledged
+  void SetSeq (uint32_t seq);
+  /// \returns the sequence number of the packet acknowledged
+  uint32_t GetSeq (void) const;
+  /// \param ts the send time of the packet acknowledged
+  void SetTs (Time ts);
+  /// \returns the send time of the packet acknowledged
+  Time GetTs (void) const;
+  /// \param ack the first sequence number not yet received
+  void SetCumulativeAck (uint32_t ack);
+  /// \returns the first sequence number not yet received
+  uint32_t GetCumulativeAck (void) const;
+  /// \param sack received sequence numbers following the cumulative ACK
+  void SetSack (uint64_t sack);
+  /// \returns received sequence numbers following the cumulative ACK
+  uint64_t GetSack (void) const;
+  /// \param count packets received with a CE mark so far
+  void SetCeCount (uint32_t count);
+  /// \returns packets received with a CE mark so far
+  uint32_t GetCeCount (void) const;
+  /**
+   * \param seq a sequence number
+   * \returns true if the header acknowledges the sequence number
+   */
+  bool IsAcked (uint32_t seq) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint32_t m_seq; //!< sequence number of the packet acknowledged
+  uint64_t m_ts; //!< send time of the packet acknowledged
+  uint32_t m_cumAck; //!< first sequence number not yet received
+  uint64_t m_sack; //!< bitmap of the SACK_BITS sequence numbers after m_cumAck
+  uint32_t m_ceCount; //!< packets received with a CE mark
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_ACK_HEADER_H */
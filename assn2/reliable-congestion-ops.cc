@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include <algorithm>
+#include <limits>
+#include "reliable-congestion-ops.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReliableCongestionOps");
+
+NS_OBJECT_ENSURE_REGISTERED (ReliableCongestionOps);
+
+TypeId
+ReliableCongestionOps::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReliableCongestionOps")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ReliableCongestionOps> ()
+    .AddAttribute ("InitialCwnd",
+                   "Initial congestion window in segments",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&ReliableCongestionOps::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacingGain",
+                   "Pacing rate relative to one congestion window per round trip",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&ReliableCongestionOps::m_pacingGain),
+                   MakeDoubleChecker<double> (0.1))
+  ;
+  return tid;
+}
+
+ReliableCongestionOps::ReliableCongestionOps ()
+  : m_segmentSize (0),
+    m_cwnd (std::numeric_limits<uint32_t>::max ()),
+    m_ssThresh (std::numeric_limits<uint32_t>::max ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ReliableCongestionOps::~ReliableCongestionOps ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::string
+ReliableCongestionOps::GetName (void) const
+{
+  return "None";
+}
+
+void
+ReliableCongestionOps::Init (uint32_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  m_segmentSize = std::max<uint32_t> (segmentSize, 1);
+  m_cwnd = std::numeric_limits<uint32_t>::max ();
+  m_ssThresh = std::numeric_limits<uint32_t>::max ();
+}
+
+void
+ReliableCongestionOps::PktsAcked (uint32_t /* bytes */, Time /* rtt */)
+{
+}
+
+void
+ReliableCongestionOps::OnLoss (void)
+{
+}
+
+bool
+ReliableCongestionOps::IsEnabled (void) const
+{
+  return false;
+}
+
+uint32_t
+ReliableCongestionOps::GetCwnd (void) const
+{
+  return m_cwnd;
+}
+
+DataRate
+ReliableCongestionOps::GetPacingRate (Time srtt) const
+{
+  if (!srtt.IsStrictlyPositive ())
+    {
+      return DataRate (0);
+    }
+  // slow start needs the headroom to double the window every round trip
+  double gain = InSlowStart () ? 2 * m_pacingGain : m_pacingGain;
+  return DataRate (static_cast<uint64_t> (gain * m_cwnd * 8 / srtt.GetSeconds ()));
+}
+
+bool
+ReliableCongestionOps::InSlowStart (void) const
+{
+  return m_cwnd < m_ssThresh;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ReliableAimd);
+
+TypeId
+ReliableAimd::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReliableAimd")
+    .SetParent<ReliableCongestionOps> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ReliableAimd> ()
+  ;
+  return tid;
+}
+
+ReliableAimd::ReliableAimd ()
+  : m_acked (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::string
+ReliableAimd::GetName (void) const
+{
+  return "Aimd";
+}
+
+void
+ReliableAimd::Init (uint32_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  ReliableCongestionOps::Init (segmentSize);
+  m_cwnd = m_initialCwnd * m_segmentSize;
+  m_acked = 0;
+}
+
+void
+ReliableAimd::PktsAcked (uint32_t bytes, Time rtt)
+{
+  NS_LOG_FUNCTION (this << bytes << rtt);
+  if (InSlowStart ())
+    {
+      m_cwnd = std::min<uint32_t> (m_cwnd + bytes, m_ssThresh);
+      return;
+    }
+  // one segment per window of echoed bytes
+  m_acked += bytes;
+  if (m_acked >= m_cwnd)
+    {
+      m_acked -= m_cwnd;
+      m_cwnd += m_segmentSize;
+    }
+}
+
+void
+ReliableAimd::OnLoss (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ssThresh = std::max<uint32_t> (m_cwnd / 2, 2 * m_segmentSize);
+  m_cwnd = m_ssThresh;
+  m_acked = 0;
+}
+
+bool
+ReliableAimd::IsEnabled (void) const
+{
+  return true;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ReliableDelayBased);
+
+TypeId
+ReliableDelayBased::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReliableDelayBased")
+    .SetParent<ReliableCongestionOps> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ReliableDelayBased> ()
+    .AddAttribute ("Alpha",
+                   "Queued packets below which the window grows",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&ReliableDelayBased::m_alpha),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Beta",
+                   "Queued packets above which the window shrinks",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&ReliableDelayBased::m_beta),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+ReliableDelayBased::ReliableDelayBased ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::string
+ReliableDelayBased::GetName (void) const
+{
+  return "DelayBased";
+}
+
+void
+ReliableDelayBased::Init (uint32_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  ReliableCongestionOps::Init (segmentSize);
+  m_cwnd = m_initialCwnd * m_segmentSize;
+  m_baseRtt = Time::Max ();
+  m_minRtt = Time::Max ();
+  m_roundEnd = Time ();
+}
+
+void
+ReliableDelayBased::PktsAcked (uint32_t bytes, Time rtt)
+{
+  NS_LOG_FUNCTION (this << bytes << rtt);
+  if (rtt.IsStrictlyPositive ())
+    {
+      m_baseRtt = std::min (m_baseRtt, rtt);
+      m_minRtt = std::min (m_minRtt, rtt);
+    }
+  Time now = Simulator::Now ();
+  if (now < m_roundEnd || m_minRtt == Time::Max ())
+    {
+      return;
+    }
+
+  // one decision per round trip, on the least queued sample of the round
+  double queued = m_cwnd * (1 - m_baseRtt.GetSeconds () / m_minRtt.GetSeconds ()) / m_segmentSize;
+  if (InSlowStart ())
+    {
+      if (queued > m_alpha)
+        {
+          // the queue is building: leave slow start on the current window
+          m_ssThresh = m_cwnd;
+        }
+      else
+        {
+          m_cwnd = std::min<uint32_t> (2 * m_cwnd, m_ssThresh);
+        }
+    }
+  else if (queued < m_alpha)
+    {
+      m_cwnd += m_segmentSize;
+    }
+  else if (queued > m_beta && m_cwnd > 2 * m_segmentSize)
+    {
+      m_cwnd -= m_segmentSize;
+    }
+  m_roundEnd = now + m_minRtt;
+  m_minRtt = Time::Max ();
+}
+
+void
+ReliableDelayBased::OnLoss (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ssThresh = std::max<uint32_t> (m_cwnd / 2, 2 * m_segmentSize);
+  m_cwnd = m_ssThresh;
+}
+
+bool
+ReliableDelayBased::IsEnabled (void) const
+{
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RELIABLE_CONGESTION_OPS_H
+#define RELIABLE_CONGESTION_OPS_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Congestion controller of UdpReliableEchoClient
+ *
+ * The controller keeps a congestion window in bytes, fed with the echoed
+ * packets and the losses seen by the client, and derives a pacing rate
+ * from it.  This base class is no congestion control at all: its window
+ * never limits the client, which then sends every Interval as before.
+ * Subclasses are selected through the client's CongestionControl
+ * attribute.
+ */
+class ReliableCongestionOps : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  ReliableCongestionOps ();
+  virtual ~ReliableCongestionOps ();
+
+  /// \returns the name of the algorithm
+  virtual std::string GetName (void) const;
+
+  /**
+   * \brief Reset the controller.
+   * \param segmentSize payload bytes of one packet
+   */
+  virtual void Init (uint32_t segmentSize);
+
+  /**
+   * \brief A packet has been echoed.
+   * \param bytes payload bytes of the packet
+   * \param rtt its round-trip time, or zero if ambiguous (retransmitted)
+   */
+  virtual void PktsAcked (uint32_t bytes, Time rtt);
+
+  /**
+   * \brief Packets have been lost; called once per loss event.
+   */
+  virtual void OnLoss (void);
+
+  /// \returns true if the window and pacing rate apply
+  virtual bool IsEnabled (void) const;
+
+  /// \returns the congestion window in bytes
+  uint32_t GetCwnd (void) const;
+
+  /**
+   * \param srtt smoothed round-trip time
+   * \returns the rate packets should be paced at
+   */
+  DataRate GetPacingRate (Time srtt) const;
+
+protected:
+  /// \returns true while the window grows exponentially
+  bool InSlowStart (void) const;
+
+  uint32_t m_segmentSize; //!< payload bytes of one packet
+  uint32_t m_initialCwnd; //!< initial window in segments
+  uint32_t m_cwnd; //!< congestion window in bytes
+  uint32_t m_ssThresh; //!< slow start threshold in bytes
+  double m_pacingGain; //!< pacing rate over cwnd / srtt
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Additive increase, multiplicative decrease
+ *
+ * Slow start doubles the window every round trip up to the slow start
+ * threshold, then the window grows by one segment per round trip and is
+ * halved on every loss event.
+ */
+class ReliableAimd : public ReliableCongestionOps
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  ReliableAimd ();
+
+  virtual std::string GetName (void) const;
+  virtual void Init (uint32_t segmentSize);
+  virtual void PktsAcked (uint32_t bytes, Time rtt);
+  virtual void OnLoss (void);
+  virtual bool IsEnabled (void) const;
+
+private:
+  uint32_t m_acked; //!< bytes echoed since the window last grew in congestion avoidance
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Delay-based control in the style of TCP Vegas
+ *
+ * Once per round trip the number of packets queued at the bottleneck is
+ * estimated as cwnd * (1 - baseRtt / rtt).  The window grows by one
+ * segment while fewer than Alpha are queued and shrinks by one while more
+ * than Beta are, so the flow keeps a small standing queue instead of
+ * filling the buffer.  Losses still halve the window.
+ */
+class ReliableDelayBased : public ReliableCongestionOps
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  ReliableDelayBased ();
+
+  virtual std::string GetName (void) const;
+  virtual void Init (uint32_t segmentSize);
+  virtual void PktsAcked (uint32_t bytes, Time rtt);
+  virtual void OnLoss (void);
+  virtual bool IsEnabled (void) const;
+
+private:
+  uint32_t m_alpha; //!< queued packets below which the window grows
+  uint32_t m_beta; //!< queued packets above which the window shrinks
+  Time m_baseRtt; //!< smallest round-trip time seen
+  Time m_minRtt; //!< smallest round-trip time of the current round
+  Time m_roundEnd; //!< end of the current round
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_CONGESTION_OPS_H */
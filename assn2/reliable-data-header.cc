@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "reliable-data-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReliableDataHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (ReliableDataHeader);
+
+ReliableDataHeader::ReliableDataHeader ()
+  : m_stream (0),
+    m_message (0),
+    m_fragment (0),
+    m_fragments (1),
+    m_offset (0),
+    m_messageSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReliableDataHeader::SetStream (uint16_t stream)
+{
+  m_stream = stream;
+}
+
+uint16_t
+ReliableDataHeader::GetStream (void) const
+{
+  return m_stream;
+}
+
+void
+ReliableDataHeader::SetMessage (uint32_t message)
+{
+  m_message = message;
+}
+
+uint32_t
+ReliableDataHeader::GetMessage (void) const
+{
+  return m_message;
+}
+
+void
+ReliableDataHeader::SetFragment (uint16_t fragment, uint16_t fragments)
+{
+  m_fragment = fragment;
+  m_fragments = fragments;
+}
+
+uint16_t
+ReliableDataHeader::GetFragment (void) const
+{
+  return m_fragment;
+}
+
+uint16_t
+ReliableDataHeader::GetFragments (void) const
+{
+  return m_fragments;
+}
+
+void
+ReliableDataHeader::SetOffset (uint32_t offset)
+{
+  m_offset = offset;
+}
+
+uint32_t
+ReliableDataHeader::GetOffset (void) const
+{
+  return m_offset;
+}
+
+void
+ReliableDataHeader::SetMessageSize (uint32_t size)
+{
+  m_messageSize = size;
+}
+
+uint32_t
+ReliableDataHeader::GetMessageSize (void) const
+{
+  return m_messageSize;
+}
+
+TypeId
+ReliableDataHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReliableDataHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ReliableDataHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ReliableDataHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ReliableDataHeader::Print (std::ostream &os) const
+{
+  os << "(stream=" << m_stream << " message=" << m_message << " fragment=" << m_fragment << "/" << m_fragments
+     << " offset=" << m_offset << " size=" << m_messageSize << ")";
+}
+
+uint32_t
+ReliableDataHeader::GetSerializedSize (void) const
+{
+  return 2 + 4 + 2 + 2 + 4 + 4;
+}
+
+void
+ReliableDataHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU16 (m_stream);
+  i.WriteHtonU32 (m_message);
+  i.WriteHtonU16 (m_fragment);
+  i.WriteHtonU16 (m_fragments);
+  i.WriteHtonU32 (m_offset);
+  i.WriteHtonU32 (m_messageSize);
+}
+
+uint32_t
+ReliableDataHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_stream = i.ReadNtohU16 ();
+  m_message = i.ReadNtohU32 ();
+  m_fragment = i.ReadNtohU16 ();
+  m_fragments = i.ReadNtohU16 ();
+  m_offset = i.ReadNtohU32 ();
+  m_messageSize = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
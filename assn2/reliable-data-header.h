@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RELIABLE_DATA_HEADER_H
+#define RELIABLE_DATA_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Message framing of UdpReliableEchoClient packets
+ *
+ * Follows the SeqTsHeader of every data packet.  An application message
+ * larger than MaxSegmentSize is split into fragments, each with its own
+ * sequence number, so each is acknowledged and retransmitted on its own;
+ * the header tells the server where the fragment goes in the message.
+ *
+ * Messages belong to a stream; each stream numbers its messages on its
+ * own, so the server assembles and delivers every stream independently.
+ */
+class ReliableDataHeader : public Header
+{
+public:
+  /// Largest number of fragments in a message
+  static const uint32_t MAX_FRAGMENTS = 64;
+
+  ReliableDataHeader ();
+
+  /// \param stream the stream the message belongs to
+  void SetStream (uint16_t stream);
+  /// \returns the stream the message belongs to
+  uint16_t GetStream (void) const;
+  /// \param message the message number
+  void SetMessage (uint32_t message);
+  /// \returns the message number
+  uint32_t GetMessage (void) const;
+  /**
+   * \param fragment index of the fragment in the message
+   * \param fragments number of fragments in the message
+   */
+  void SetFragment (uint16_t fragment, uint16_t fragments);
+  /// \returns the index of the fragment in the message
+  uint16_t GetFragment (void) const;
+  /// \returns the number of fragments in the message
+  uint16_t GetFragments (void) const;
+  /// \param offset position of the fragment's first byte in the message
+  void SetOffset (uint32_t offset);
+  /// \returns the position of the fragment's first byte in the message
+  uint32_t GetOffset (void) const;
+  /// \param size payload bytes of the whole message
+  void SetMessageSize (uint32_t size);
+  /// \returns payload bytes of the whole message
+  uint32_t GetMessageSize (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint16_t m_stream; //!< stream of the message
+  uint32_t m_message; //!< message number within the stream
+  uint16_t m_fragment; //!< index of the fragment
+  uint16_t m_fragments; //!< fragments in the message
+  uint32_t m_offset; //!< position of the fragment in the message
+  uint32_t m_messageSize; //!< bytes of the whole message
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_DATA_HEADER_H */
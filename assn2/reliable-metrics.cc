@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "reliable-metrics.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReliableMetricsSink");
+
+namespace {
+
+/**
+ * \param p where to write
+ * \param v value to store little-endian
+ * \param bytes width of the value
+ * \returns the byte after the value
+ */
+uint8_t *
+PutLe (uint8_t *p, uint64_t v, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      *p++ = static_cast<uint8_t> (v >> (8 * i));
+    }
+  return p;
+}
+
+} // anonymous namespace
+
+ReliableMetricsSink::ReliableMetricsSink ()
+  : m_file (0),
+    m_format (CSV)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ReliableMetricsSink::~ReliableMetricsSink ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+ReliableMetricsSink::Open (std::string path, Format format)
+{
+  NS_LOG_FUNCTION (this << path << format);
+  Close ();
+  m_file = std::fopen (path.c_str (), format == CSV ? "w" : "wb");
+  if (m_file == 0)
+    {
+      NS_LOG_WARN ("Cannot create metrics file " << path);
+      return false;
+    }
+  m_format = format;
+  if (m_format == CSV)
+    {
+      std::fputs ("time,sent,resent,echoed,lost,abandoned,inflight,inflight_bytes,"
+                  "cwnd,goodput_bps,srtt,rto\n", m_file);
+    }
+  else
+    {
+      std::fwrite ("RMT1", 1, 4, m_file);
+    }
+  std::fflush (m_file);
+  return true;
+}
+
+void
+ReliableMetricsSink::Close (void)
+{
+  if (m_file != 0)
+    {
+      std::fclose (m_file);
+      m_file = 0;
+    }
+}
+
+void
+ReliableMetricsSink::Write (const ReliableMetrics &metrics)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  if (m_format == CSV)
+    {
+      std::fprintf (m_file, "%.6f,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%.6f,%.6f\n",
+                    metrics.time.GetSeconds (), metrics.sent, metrics.resent,
+                    metrics.echoed, metrics.lost, metrics.abandoned,
+                    metrics.inFlight, metrics.inFlightBytes, metrics.cwnd,
+                    static_cast<unsigned long long> (metrics.goodput),
+                    metrics.srtt.GetSeconds (), metrics.rto.GetSeconds ());
+    }
+  else
+    {
+      uint8_t record[64];
+      uint8_t *p = record;
+      p = PutLe (p, metrics.time.GetNanoSeconds (), 8);
+      p = PutLe (p, metrics.sent, 4);
+      p = PutLe (p, metrics.resent, 4);
+      p = PutLe (p, metrics.echoed, 4);
+      p = PutLe (p, metrics.lost, 4);
+      p = PutLe (p, metrics.abandoned, 4);
+      p = PutLe (p, metrics.inFlight, 4);
+      p = PutLe (p, metrics.inFlightBytes, 4);
+      p = PutLe (p, metrics.cwnd, 4);
+      p = PutLe (p, metrics.goodput, 8);
+      p = PutLe (p, metrics.srtt.GetNanoSeconds (), 8);
+      p = PutLe (p, metrics.rto.GetNanoSeconds (), 8);
+      std::fwrite (record, 1, p - record, m_file);
+    }
+  std::fflush (m_file);
+}
+
+} // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RELIABLE_METRICS_H
+#define RELIABLE_METRICS_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief One periodic sample of UdpReliableEchoClient progress
+ *
+ * Counters are totals since the application started; goodput covers the
+ * last sampling interval only.
+ */
+struct ReliableMetrics
+{
+  Time time;              //!< sampling time
+  uint32_t sent;          //!< packets sent for the first time
+  uint32_t resent;        //!< retransmissions
+  uint32_t echoed;        //!< packets acknowledged
+  uint32_t lost;          //!< packets detected as lost
+  uint32_t abandoned;     //!< packets given up after MaxRetries
+  uint32_t inFlight;      //!< packets outstanding
+  uint32_t inFlightBytes; //!< payload bytes outstanding
+  uint32_t cwnd;          //!< congestion window in bytes
+  uint64_t goodput;       //!< acknowledged payload bits per second
+  Time srtt;              //!< smoothed round-trip time
+  Time rto;               //!< retransmission timeout, before backoff
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Writer of ReliableMetrics samples to a file
+ *
+ * Connect Write to the client's Metrics trace source.  Every sample is
+ * flushed as it is written, so a run can be watched, and stopped, while
+ * it goes.
+ *
+ * Two formats are written:
+ * - CSV: a header line, then one line per sample; times in seconds
+ * - binary: the four bytes "RMT1" followed by one 64-byte little-endian
+ *   record per sample: time (int64, ns), sent, resent, echoed, lost,
+ *   abandoned, inFlight, inFlightBytes, cwnd (uint32), goodput (uint64,
+ *   bit/s), srtt, rto (int64, ns)
+ */
+class ReliableMetricsSink
+{
+public:
+  /// File formats
+  enum Format
+  {
+    CSV,    //!< comma-separated text
+    BINARY  //!< fixed-size little-endian records
+  };
+
+  ReliableMetricsSink ();
+  ~ReliableMetricsSink ();
+
+  /**
+   * \brief Create a file and write its header, closing any file already open.
+   * \param path the file
+   * \param format the file format
+   * \returns false if the file cannot be created
+   */
+  bool Open (std::string path, Format format);
+
+  /// \brief Close the file.
+  void Close (void);
+
+  /**
+   * \brief Append one sample.
+   * \param metrics the sample
+   */
+  void Write (const ReliableMetrics &metrics);
+
+private:
+  std::FILE *m_file; //!< file being written, or a null pointer
+  Format m_format;   //!< format of m_file
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_METRICS_H */
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "reliable-session-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReliableSessionTable");
+
+ReliableSessionTable::ReliableSessionTable ()
+  : m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReliableSessionTable::Init (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  uint32_t slots = 1;
+  while (slots < capacity)
+    {
+      slots <<= 1;
+    }
+  m_sessions.assign (slots, Session ());
+  m_hashes.assign (slots, 0);
+  m_used.assign (slots, false);
+  m_size = 0;
+}
+
+uint32_t
+ReliableSessionTable::Hash (const Address &peer)
+{
+  uint8_t buffer[Address::MAX_SIZE];
+  uint32_t len = peer.CopyAllTo (buffer, Address::MAX_SIZE);
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < len; i++)
+    {
+      hash = (hash ^ buffer[i]) * 16777619u;
+    }
+  return hash;
+}
+
+uint32_t
+ReliableSessionTable::Probe (const Address &peer, uint32_t hash) const
+{
+  uint32_t mask = m_sessions.size () - 1;
+  uint32_t slot = hash & mask;
+  while (m_used[slot] && (m_hashes[slot] != hash || m_sessions[slot].peer != peer))
+    {
+      slot = (slot + 1) & mask;
+    }
+  return slot;
+}
+
+ReliableSessionTable::Session *
+ReliableSessionTable::Find (const Address &peer)
+{
+  if (m_sessions.empty ())
+    {
+      return 0;
+    }
+  uint32_t slot = Probe (peer, Hash (peer));
+  return m_used[slot] ? &m_sessions[slot] : 0;
+}
+
+ReliableSessionTable::Session &
+ReliableSessionTable::Insert (const Address &peer)
+{
+  if (2 * (m_size + 1) > m_sessions.size ())
+    {
+      Grow ();
+    }
+  uint32_t hash = Hash (peer);
+  uint32_t slot = Probe (peer, hash);
+  if (!m_used[slot])
+    {
+      NS_LOG_LOGIC ("New session " << peer << " in slot " << slot);
+      Session &session = m_sessions[slot];
+      session = Session ();
+      session.peer = peer;
+      session.received = 0;
+      session.duplicates = 0;
+      session.bytes = 0;
+      session.messages = 0;
+      session.pending = 0;
+      session.seq = 0;
+      session.ceCount = 0;
+      m_hashes[slot] = hash;
+      m_used[slot] = true;
+      m_size++;
+    }
+  return m_sessions[slot];
+}
+
+void
+ReliableSessionTable::Grow (void)
+{
+  NS_LOG_FUNCTION (this << m_sessions.size ());
+  std::vector<Session> sessions;
+  std::vector<uint32_t> hashes;
+  std::vector<bool> used;
+  sessions.swap (m_sessions);
+  hashes.swap (m_hashes);
+  used.swap (m_used);
+
+  uint32_t slots = sessions.empty () ? 16 : 2 * sessions.size ();
+  m_sessions.assign (slots, Session ());
+  m_hashes.assign (slots, 0);
+  m_used.assign (slots, false);
+  for (uint32_t i = 0; i < sessions.size (); i++)
+    {
+      if (used[i])
+        {
+          uint32_t slot = Probe (sessions[i].peer, hashes[i]);
+          m_sessions[slot] = sessions[i];
+          m_hashes[slot] = hashes[i];
+          m_used[slot] = true;
+        }
+    }
+}
+
+ReliableSessionTable::Session *
+ReliableSessionTable::At (uint32_t slot)
+{
+  return m_used[slot] ? &m_sessions[slot] : 0;
+}
+
+uint32_t
+ReliableSessionTable::GetSize (void) const
+{
+  return m_size;
+}
+
+uint32_t
+ReliableSessionTable::GetCapacity (void) const
+{
+  return m_sessions.size ();
+}
+
+} // namespace ns3
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RELIABLE_SESSION_TABLE_H
+#define RELIABLE_SESSION_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "sack-receive-window.h"
+#include "message-reassembly-buffer.h"
+#include "in-order-delivery-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Per-client state of UdpReliableEchoServer, keyed by socket address
+ *
+ * Sessions are kept in an open-addressed table with linear probing on a
+ * hash of the serialized address, so finding the session of a packet
+ * costs O(1) whatever the number of clients.  The table doubles before
+ * it is half full.  Sessions are never removed while the server runs.
+ */
+class ReliableSessionTable
+{
+public:
+  /// State of one client
+  struct Session
+  {
+    Address peer; //!< client socket address
+    SackReceiveWindow window; //!< packets received
+    uint32_t received; //!< distinct packets received
+    uint32_t duplicates; //!< packets received more than once
+    uint64_t bytes; //!< payload bytes of distinct packets
+    uint32_t messages; //!< messages received whole
+    std::vector<MessageReassemblyBuffer> reassembly; //!< fragmented messages by stream, allocated on first use
+    std::vector<InOrderDeliveryBuffer> delivery; //!< complete messages by stream, released in order
+    uint32_t pending; //!< packets received since the last ACK
+    Time firstPending; //!< arrival of the oldest of them
+    uint32_t seq; //!< sequence number of the newest packet received
+    Time ts; //!< its SeqTsHeader timestamp
+    uint32_t ceCount; //!< packets received with a CE mark
+    EventId ackEvent; //!< delayed ACK timer
+  };
+
+  ReliableSessionTable ();
+
+  /**
+   * \brief Drop all sessions and size the table.
+   * \param capacity initial number of slots, rounded up to a power of two
+   */
+  void Init (uint32_t capacity);
+
+  /**
+   * \param peer client socket address
+   * \returns the session of the client, or a null pointer
+   */
+  Session *Find (const Address &peer);
+
+  /**
+   * \brief Get the session of a client, created if needed.
+   *
+   * Creating a session may grow the table, which invalidates pointers to
+   * other sessions.
+   *
+   * \param peer client socket address
+   * \returns the session
+   */
+  Session &Insert (const Address &peer);
+
+  /**
+   * \param slot slot number, below GetCapacity ()
+   * \returns the session in the slot, or a null pointer if it is empty
+   */
+  Session *At (uint32_t slot);
+
+  /// \returns the number of sessions
+  uint32_t GetSize (void) const;
+  /// \returns the number of slots
+  uint32_t GetCapacity (void) const;
+
+private:
+  /**
+   * \param peer a socket address
+   * \returns the hash of its serialized form
+   */
+  static uint32_t Hash (const Address &peer);
+  /**
+   * \param peer a socket address
+   * \param hash its hash
+   * \returns the slot holding the peer, or the empty slot it would go in
+   */
+  uint32_t Probe (const Address &peer, uint32_t hash) const;
+  /// \brief Double the number of slots and rehash every session.
+  void Grow (void);
+
+  std::vector<Session> m_sessions; //!< slots
+  std::vector<uint32_t> m_hashes; //!< hash of every slot's peer
+  std::vector<bool> m_used; //!< slot holds a session
+  uint32_t m_size; //!< sessions in the table
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_SESSION_TABLE_H */
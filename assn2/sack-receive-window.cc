@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "reliable-ack-header.h"
+#include "sack-receive-window.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SackReceiveWindow");
+
+SackReceiveWindow::SackReceiveWindow ()
+  : m_cumAck (0),
+    m_sack (0),
+    m_skipped (0)
+{
+}
+
+bool
+SackReceiveWindow::Receive (uint32_t seq)
+{
+  int32_t distance = static_cast<int32_t> (seq - m_cumAck);
+  if (distance < 0)
+    {
+      return false;
+    }
+  while (seq - m_cumAck > ReliableAckHeader::SACK_BITS)
+    {
+      NS_LOG_LOGIC ("Skipping hole " << m_cumAck);
+      m_skipped++;
+      Advance ();
+    }
+  if (seq != m_cumAck)
+    {
+      uint64_t bit = uint64_t (1) << (seq - m_cumAck - 1);
+      if (m_sack & bit)
+        {
+          return false;
+        }
+      m_sack |= bit;
+      return true;
+    }
+  Advance ();
+  return true;
+}
+
+void
+SackReceiveWindow::Advance (void)
+{
+  // drop m_cumAck, then every received sequence number right after it
+  bool received;
+  do
+    {
+      m_cumAck++;
+      received = m_sack & 1;
+      m_sack >>= 1;
+    }
+  while (received);
+}
+
+uint32_t
+SackReceiveWindow::GetCumulativeAck (void) const
+{
+  return m_cumAck;
+}
+
+uint64_t
+SackReceiveWindow::GetSack (void) const
+{
+  return m_sack;
+}
+
+uint32_t
+SackReceiveWindow::GetSkipped (void) const
+{
+  return m_skipped;
+}
+
+} // namespace ns3
@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SACK_RECEIVE_WINDOW_H
+#define SACK_RECEIVE_WINDOW_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Receive state behind a ReliableAckHeader
+ *
+ * Keeps the cumulative ACK and a bitmap of the ReliableAckHeader::SACK_BITS
+ * sequence numbers after it, so recording a packet is O(1) apart from the
+ * slide over packets that were already received.
+ *
+ * A packet too far ahead of the cumulative ACK to fit in the bitmap can
+ * only follow a hole the sender gave up on, since its window is no larger
+ * than the bitmap; the cumulative ACK then jumps over that hole.
+ */
+class SackReceiveWindow
+{
+public:
+  SackReceiveWindow ();
+
+  /**
+   * \brief Record the arrival of a packet.
+   * \param seq sequence number
+   * \returns false if the packet had already been received
+   */
+  bool Receive (uint32_t seq);
+
+  /// \returns the first sequence number not yet received
+  uint32_t GetCumulativeAck (void) const;
+  /// \returns the bitmap of sequence numbers received after the cumulative ACK
+  uint64_t GetSack (void) const;
+  /// \returns sequence numbers skipped over without being received
+  uint32_t GetSkipped (void) const;
+
+private:
+  /// \brief Move the cumulative ACK one sequence number forward.
+  void Advance (void);
+
+  uint32_t m_cumAck; //!< first sequence number not yet received
+  uint64_t m_sack; //!< bit i: m_cumAck + 1 + i received
+  uint32_t m_skipped; //!< holes the cumulative ACK jumped over
+};
+
+} // namespace ns3
+
+#endif /* SACK_RECEIVE_WINDOW_H */
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "selective-repeat-window.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SelectiveRepeatWindow");
+
+SelectiveRepeatWindow::SelectiveRepeatWindow ()
+  : m_base (0),
+    m_next (0),
+    m_inFlight (0),
+    m_bytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SelectiveRepeatWindow::Init (uint32_t window)
+{
+  NS_LOG_FUNCTION (this << window);
+  NS_ASSERT_MSG (window > 0, "SelectiveRepeatWindow::Init(): empty window");
+  Entry empty = { 0, 0, 0, Time (), Time (), Time (), false };
+  m_entries.assign (window, empty);
+  m_base = 0;
+  m_next = 0;
+  m_inFlight = 0;
+  m_bytes = 0;
+}
+
+bool
+SelectiveRepeatWindow::CanSend (uint32_t size, uint32_t maxBytes) const
+{
+  if (m_next - m_base >= m_entries.size ())
+    {
+      return false;
+    }
+  // a packet larger than the cap still goes out on an empty window
+  return maxBytes == 0 || m_inFlight == 0 || m_bytes + size <= maxBytes;
+}
+
+SelectiveRepeatWindow::Entry &
+SelectiveRepeatWindow::Add (uint32_t size, Time now)
+{
+  NS_LOG_FUNCTION (this << m_next << size);
+  NS_ASSERT_MSG (m_next - m_base < m_entries.size (), "SelectiveRepeatWindow::Add(): window full");
+  Entry &entry = m_entries[m_next % m_entries.size ()];
+  entry.seq = m_next++;
+  entry.size = size;
+  entry.retries = 0;
+  entry.firstTx = now;
+  entry.lastTx = now;
+  entry.deadline = Time ();
+  entry.outstanding = true;
+  m_inFlight++;
+  m_bytes += size;
+  return entry;
+}
+
+SelectiveRepeatWindow::Entry *
+SelectiveRepeatWindow::Get (uint32_t seq)
+{
+  if (seq - m_base >= m_next - m_base)
+    {
+      return 0;
+    }
+  Entry &entry = m_entries[seq % m_entries.size ()];
+  if (!entry.outstanding || entry.seq != seq)
+    {
+      return 0;
+    }
+  return &entry;
+}
+
+bool
+SelectiveRepeatWindow::Remove (uint32_t seq, Entry &removed)
+{
+  NS_LOG_FUNCTION (this << seq);
+  Entry *entry = Get (seq);
+  if (entry == 0)
+    {
+      return false;
+    }
+  entry->outstanding = false;
+  removed = *entry;
+  m_inFlight--;
+  m_bytes -= entry->size;
+  while (m_base != m_next && !m_entries[m_base % m_entries.size ()].outstanding)
+    {
+      m_base++;
+    }
+  return true;
+}
+
+uint32_t
+SelectiveRepeatWindow::GetBase (void) const
+{
+  return m_base;
+}
+
+uint32_t
+SelectiveRepeatWindow::GetNext (void) const
+{
+  return m_next;
+}
+
+uint32_t
+SelectiveRepeatWindow::GetInFlight (void) const
+{
+  return m_inFlight;
+}
+
+uint32_t
+SelectiveRepeatWindow::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+} // namespace ns3
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SELECTIVE_REPEAT_WINDOW_H
+#define SELECTIVE_REPEAT_WINDOW_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Send window of a selective-repeat sender
+ *
+ * Sequence numbers in [base, next) are tracked in a ring of window
+ * entries, sequence s living in entry s % window, so adding, looking up
+ * and acknowledging a packet are O(1).  The base only moves past packets
+ * that were acknowledged or abandoned, so a lost packet holds the window
+ * until it is repaired or given up.
+ */
+class SelectiveRepeatWindow
+{
+public:
+  /// State of an outstanding packet
+  struct Entry
+  {
+    uint32_t seq;      //!< sequence number
+    uint32_t size;     //!< payload bytes
+    uint32_t retries;  //!< retransmissions so far
+    Time firstTx;      //!< time of the first transmission
+    Time lastTx;       //!< time of the latest transmission
+    Time deadline;     //!< retransmission deadline
+    bool outstanding;  //!< sent and neither acknowledged nor abandoned
+  };
+
+  SelectiveRepeatWindow ();
+
+  /**
+   * \brief Empty the window and set its size.
+   * \param window largest number of outstanding packets
+   */
+  void Init (uint32_t window);
+
+  /**
+   * \param size payload bytes of the next packet
+   * \param maxBytes cap on outstanding bytes (0 for none)
+   * \returns true if the next packet fits in the window and the byte cap
+   */
+  bool CanSend (uint32_t size, uint32_t maxBytes) const;
+
+  /**
+   * \brief Record the first transmission of the next sequence number.
+   * \param size payload bytes
+   * \param now send time
+   * \returns the new entry
+   */
+  Entry &Add (uint32_t size, Time now);
+
+  /**
+   * \param seq sequence number
+   * \returns the entry of an outstanding packet, or a null pointer
+   */
+  Entry *Get (uint32_t seq);
+
+  /**
+   * \brief Stop tracking a packet, acknowledged or abandoned, and slide
+   * the window base past every packet no longer outstanding.
+   * \param seq sequence number
+   * \param removed filled with the entry of the packet
+   * \returns false if the packet was not outstanding
+   */
+  bool Remove (uint32_t seq, Entry &removed);
+
+  /// \returns the oldest sequence number still outstanding, or GetNext () if none
+  uint32_t GetBase (void) const;
+  /// \returns the next sequence number to be sent
+  uint32_t GetNext (void) const;
+  /// \returns the number of outstanding packets
+  uint32_t GetInFlight (void) const;
+  /// \returns the payload bytes of the outstanding packets
+  uint32_t GetBytes (void) const;
+
+private:
+  std::vector<Entry> m_entries; //!< ring of entries
+  uint32_t m_base;              //!< oldest sequence number not yet released
+  uint32_t m_next;              //!< next sequence number
+  uint32_t m_inFlight;          //!< outstanding packets
+  uint32_t m_bytes;             //!< outstanding payload bytes
+};
+
+} // namespace ns3
+
+#endif /* SELECTIVE_REPEAT_WINDOW_H */
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/log.h"
+#include <algorithm>
+#include "timer-wheel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimerWheel");
+
+TimerWheel::TimerWheel ()
+  : m_current (0),
+    m_timers (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TimerWheel::Init (Time granularity, uint32_t slots)
+{
+  NS_LOG_FUNCTION (this << granularity << slots);
+  NS_ASSERT_MSG (granularity.IsStrictlyPositive () && slots > 0,
+                 "TimerWheel::Init(): empty wheel");
+  m_granularity = granularity;
+  m_slots.assign (slots, std::vector<Timer> ());
+  m_current = 0;
+  m_timers = 0;
+}
+
+uint64_t
+TimerWheel::ToTick (Time t) const
+{
+  int64_t step = m_granularity.GetTimeStep ();
+  return (std::max<int64_t> (t.GetTimeStep (), 0) + step - 1) / step;
+}
+
+void
+TimerWheel::Schedule (uint32_t id, Time deadline)
+{
+  NS_LOG_FUNCTION (this << id << deadline);
+  Timer timer;
+  timer.id = id;
+  timer.deadline = deadline;
+  timer.tick = std::max (ToTick (deadline), m_current);
+  m_slots[timer.tick % m_slots.size ()].push_back (timer);
+  m_timers++;
+}
+
+void
+TimerWheel::Advance (Time now, std::vector<Timer> &expired)
+{
+  NS_LOG_FUNCTION (this << now);
+  // ticks are processed once the whole tick has elapsed
+  uint64_t end = now.GetTimeStep () / m_granularity.GetTimeStep ();
+  if (end < m_current)
+    {
+      return;
+    }
+  uint64_t steps = std::min<uint64_t> (end - m_current + 1, m_slots.size ());
+  for (uint64_t i = 0; i < steps && m_timers > 0; i++)
+    {
+      std::vector<Timer> &slot = m_slots[(m_current + i) % m_slots.size ()];
+      uint32_t kept = 0;
+      for (uint32_t j = 0; j < slot.size (); j++)
+        {
+          if (slot[j].tick <= end)
+            {
+              expired.push_back (slot[j]);
+              m_timers--;
+            }
+          else
+            {
+              slot[kept++] = slot[j];
+            }
+        }
+      slot.resize (kept);
+    }
+  m_current = end + 1;
+}
+
+bool
+TimerWheel::IsEmpty (void) const
+{
+  return m_timers == 0;
+}
+
+Time
+TimerWheel::GetGranularity (void) const
+{
+  return m_granularity;
+}
+
+} // namespace ns3
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Hashed timer wheel holding many deadlines behind one periodic tick
+ *
+ * A deadline is rounded up to the next tick and hashed to slot
+ * tick % slots; deadlines more than one revolution away simply stay in
+ * their slot until their round comes.  Scheduling is O(1) and a tick
+ * costs the timers of one slot, so the owner needs a single simulator
+ * event however many timers are armed.
+ *
+ * Timers are never cancelled: the owner re-checks every expired timer
+ * against its own state and ignores the stale ones.
+ */
+class TimerWheel
+{
+public:
+  /// An armed timer
+  struct Timer
+  {
+    uint32_t id;     //!< owner-defined identifier
+    Time deadline;   //!< time the timer expires
+    uint64_t tick;   //!< tick the deadline was rounded up to
+  };
+
+  TimerWheel ();
+
+  /**
+   * \brief Drop all timers and set the wheel geometry.
+   * \param granularity duration of one tick
+   * \param slots number of slots
+   */
+  void Init (Time granularity, uint32_t slots);
+
+  /**
+   * \brief Arm a timer.
+   * \param id owner-defined identifier
+   * \param deadline time the timer expires
+   */
+  void Schedule (uint32_t id, Time deadline);
+
+  /**
+   * \brief Move the wheel forward and collect the expired timers.
+   * \param now current time
+   * \param expired filled with the timers whose deadline has passed
+   */
+  void Advance (Time now, std::vector<Timer> &expired);
+
+  /// \returns true if no timer is armed
+  bool IsEmpty (void) const;
+
+  /// \returns the duration of one tick
+  Time GetGranularity (void) const;
+
+private:
+  /**
+   * \param t a time
+   * \returns the first tick at or after t
+   */
+  uint64_t ToTick (Time t) const;
+
+  std::vector<std::vector<Timer> > m_slots; //!< timers hashed by tick
+  Time m_granularity;                       //!< duration of one tick
+  uint64_t m_current;                       //!< first tick not yet processed
+  uint32_t m_timers;                        //!< timers armed
+};
+
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
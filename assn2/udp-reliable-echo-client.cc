@@ -28,7 +28,12 @@
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/seq-ts-header.h"
+#include "ns3/object-factory.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "udp-reliable-echo-client.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -53,6 +58,12 @@ UdpReliableEchoClient::GetTypeId (void)
                    TimeValue (Seconds (1.0)),
                    MakeTimeAccessor (&UdpReliableEchoClient::m_interval),
                    MakeTimeChecker ())
+    .AddAttribute ("BulkBytes",
+                   "Bytes to transfer as fast as the window allows, instead of "
+                   "MaxPackets every Interval (0 for no bulk transfer)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_bulkBytes),
+                   MakeUintegerChecker<uint64_t> ())
     .AddAttribute ("RemoteAddress", 
                    "The destination Address of the outbound packets",
                    AddressValue (),
@@ -63,11 +74,99 @@ UdpReliableEchoClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&UdpReliableEchoClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of echo data in outbound packets; "
+                   "messages larger than MaxSegmentSize are sent in fragments",
                    UintegerValue (100),
                    MakeUintegerAccessor (&UdpReliableEchoClient::SetDataSize,
                                          &UdpReliableEchoClient::GetDataSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxSegmentSize",
+                   "Largest payload of one packet; larger messages are fragmented",
+                   UintegerValue (1400),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_segmentSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Priority",
+                   "Scheduling priority of stream 0 against streams added by "
+                   "AddStream; lower values are sent first",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_priority),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("WindowSize",
+                   "Largest number of packets sent but not yet echoed",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_windowSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxInFlightBytes",
+                   "Largest number of payload bytes sent but not yet echoed (0 for no limit)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_maxInFlightBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxRetries",
+                   "Retransmissions of a packet before it is abandoned",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_maxRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RetransmissionTimeout",
+                   "Time to wait for an echo before sending a packet again, "
+                   "until the first round-trip time sample",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&UdpReliableEchoClient::m_initialRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("MinRto",
+                   "Lower bound of the retransmission timeout",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&UdpReliableEchoClient::m_minRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxRto",
+                   "Upper bound of the retransmission timeout, backoff included",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&UdpReliableEchoClient::m_maxRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("TimerGranularity",
+                   "Tick of the retransmission timer wheel",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&UdpReliableEchoClient::m_granularity),
+                   MakeTimeChecker ())
+    .AddAttribute ("AckMode",
+                   "How the server acknowledges packets; must match its AckMode",
+                   EnumValue (ACK_ECHO),
+                   MakeEnumAccessor (&UdpReliableEchoClient::m_ackMode),
+                   MakeEnumChecker (ACK_ECHO, "Echo",
+                                    ACK_SACK, "Sack"))
+    .AddAttribute ("LossDetection",
+                   "How acknowledgements of later packets reveal a lost one",
+                   EnumValue (TIME_THRESHOLD),
+                   MakeEnumAccessor (&UdpReliableEchoClient::m_lossDetection),
+                   MakeEnumChecker (PACKET_THRESHOLD, "Packet",
+                                    TIME_THRESHOLD, "Time"))
+    .AddAttribute ("ReorderThreshold",
+                   "Packets acknowledged after an outstanding one before it is "
+                   "taken as lost, with Packet loss detection",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&UdpReliableEchoClient::m_reorderThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ReorderWindow",
+                   "Reordering allowed for, as a fraction of SRTT, with Time loss detection",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UdpReliableEchoClient::m_reorderWindow),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("Ecn",
+                   "Send ECN-capable packets and back off on the Congestion Experienced "
+                   "marks the server reports (AckMode Sack)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpReliableEchoClient::m_ecn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MetricsInterval",
+                   "Time between samples of the Metrics trace source (0 for none)",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&UdpReliableEchoClient::m_metricsInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("CongestionControl",
+                   "Congestion controller limiting and pacing the packets in flight "
+                   "(ns3::ReliableCongestionOps to send every Interval)",
+                   TypeIdValue (ReliableAimd::GetTypeId ()),
+                   MakeTypeIdAccessor (&UdpReliableEchoClient::m_ccType),
+                   MakeTypeIdChecker ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&UdpReliableEchoClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -80,6 +179,31 @@ UdpReliableEchoClient::GetTypeId (void)
     .AddTraceSource ("RxWithAddresses", "A packet has been received",
                      MakeTraceSourceAccessor (&UdpReliableEchoClient::m_rxTraceWithAddresses),
                      "ns3::Packet::TwoAddressTracedCallback")
+    .AddTraceSource ("SRTT", "Smoothed round-trip time",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_srtt),
+                     "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("RTTVAR", "Round-trip time variation",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_rttvar),
+                     "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("RTO", "Retransmission timeout, before exponential backoff",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_rto),
+                     "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("SpuriousRetransmission",
+                     "A retransmitted packet turned out to have been delivered the first time",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_spuriousTrace),
+                     "ns3::UdpReliableEchoClient::SpuriousTracedCallback")
+    .AddTraceSource ("Metrics",
+                     "Counters, goodput, in-flight data and RTT, sampled every MetricsInterval",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_metricsTrace),
+                     "ns3::UdpReliableEchoClient::MetricsTracedCallback")
+    .AddTraceSource ("FlowComplete",
+                     "A bulk transfer has been acknowledged, with its completion time, "
+                     "time to first byte and bytes delivered",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_flowCompleteTrace),
+                     "ns3::UdpReliableEchoClient::FlowCompleteTracedCallback")
+    .AddTraceSource ("CongestionWindow", "Congestion window in bytes",
+                     MakeTraceSourceAccessor (&UdpReliableEchoClient::m_cwnd),
+                     "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
 }
@@ -98,6 +222,27 @@ UdpReliableEchoClient::UdpReliableEchoClient ()
   lossNumber = 0;
   reNumber = 0;
   lastEchoNumber = 0;
+  m_blocked = false;
+  m_blockedSize = 0;
+  m_abandoned = 0;
+  m_backoff = 0;
+  m_ackMode = ACK_ECHO;
+  m_recover = 0;
+  m_lossDetection = TIME_THRESHOLD;
+  m_highestAcked = 0;
+  m_spurious = 0;
+  m_ecn = false;
+  m_ceCount = 0;
+  m_ecnReductions = 0;
+  m_echoed = 0;
+  m_ackedBytes = 0;
+  m_sampledBytes = 0;
+  m_bulkBytes = 0;
+  m_bulkQueued = 0;
+  m_flowDone = false;
+  m_flowAckedBytes = 0;
+  m_priority = 0;
+  m_nextStream = 0;
 }
 
 UdpReliableEchoClient::~UdpReliableEchoClient()
@@ -105,6 +250,9 @@ UdpReliableEchoClient::~UdpReliableEchoClient()
   NS_LOG_FUNCTION (this);
   NS_LOG_INFO("Q1)Packet Drop Ratio:" << (float(lossNumber + seqNumber - lastEchoNumber)*100. / float(seqNumber)) << "%");
   NS_LOG_INFO("Q2)Packet Retransmit Success Ratio:" << (float(reNumber) * 100. / float(lossNumber)) << "%");
+  NS_LOG_INFO("Packets Abandoned:" << m_abandoned);
+  NS_LOG_INFO("Spurious Retransmissions:" << m_spurious);
+  NS_LOG_INFO("Retransmissions:" << m_resent << " ECN Reductions:" << m_ecnReductions);
   m_socket = 0;
 
   delete [] m_data;
@@ -127,10 +275,26 @@ UdpReliableEchoClient::SetRemote (Address addr)
   m_peerAddress = addr;
 }
 
+uint16_t
+UdpReliableEchoClient::AddStream (uint32_t size, Time interval, uint32_t priority, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << size << interval << priority << count);
+  Stream stream = Stream ();
+  stream.size = size;
+  stream.interval = interval;
+  stream.priority = priority;
+  stream.count = count;
+  m_addedStreams.push_back (stream);
+  return m_addedStreams.size ();
+}
+
 void
 UdpReliableEchoClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_cc = 0;
+  m_payload = 0;
+  m_streams.clear ();
   Application::DoDispose ();
 }
 
@@ -183,6 +347,74 @@ UdpReliableEchoClient::StartApplication (void)
 
   m_socket->SetRecvCallback (MakeCallback (&UdpReliableEchoClient::HandleRead, this));
   m_socket->SetAllowBroadcast (true);
+  if (m_ecn)
+    {
+      if (m_ackMode != ACK_SACK)
+        {
+          NS_LOG_WARN ("Ecn without AckMode Sack: CE marks are not reported back");
+        }
+      // ECT(0) in the low bits of the TOS byte
+      m_socket->SetIpTos (0x02);
+    }
+  uint32_t windowSize = m_windowSize;
+  if (m_ackMode == ACK_SACK)
+    {
+      // a hole must stay within reach of the SACK bitmap
+      windowSize = std::min (windowSize, ReliableAckHeader::SACK_BITS);
+    }
+  m_window.Init (windowSize);
+  m_dataHeaders.assign (windowSize, ReliableDataHeader ());
+  Stream stream = Stream ();
+  stream.size = m_size;
+  stream.interval = m_interval;
+  stream.count = m_count;
+  stream.priority = m_priority;
+  m_streams.assign (1, stream);
+  m_streams.insert (m_streams.end (), m_addedStreams.begin (), m_addedStreams.end ());
+  m_streams[0].payload = m_payload;
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      if (i > 0)
+        {
+          m_streams[i].payload = Create<Packet> (m_streams[i].size);
+        }
+      NS_ABORT_MSG_IF ((m_streams[i].size + m_segmentSize - 1) / m_segmentSize > ReliableDataHeader::MAX_FRAGMENTS,
+                       "UdpReliableEchoClient: messages of stream " << i << " need more than "
+                       << ReliableDataHeader::MAX_FRAGMENTS << " fragments of MaxSegmentSize");
+      m_streams[i].nextMessage = Simulator::Now ();
+    }
+  m_nextStream = 0;
+  m_recover = 0;
+  m_wheel.Init (m_granularity, 256);
+  m_blocked = false;
+  m_blockedSize = 0;
+  m_srtt = Time ();
+  m_rttvar = Time ();
+  m_rto = m_initialRto;
+  m_backoff = 0;
+  ObjectFactory factory;
+  factory.SetTypeId (m_ccType);
+  m_cc = factory.Create<ReliableCongestionOps> ();
+  m_cc->Init (std::min (m_size, m_segmentSize));
+  m_cwnd = m_cc->GetCwnd ();
+  if (m_cc->IsEnabled () || m_bulkBytes > 0)
+    {
+      // stream 0 sends as fast as the windows and pacing allow
+      m_streams[0].interval = Time ();
+    }
+  m_highestAcked = 0;
+  m_rackXmit = Time ();
+  m_ceCount = 0;
+  m_sampledBytes = m_ackedBytes;
+  if (m_metricsInterval.IsStrictlyPositive ())
+    {
+      m_metricsEvent = Simulator::Schedule (m_metricsInterval, &UdpReliableEchoClient::SampleMetrics, this);
+    }
+  m_bulkQueued = 0;
+  m_flowDone = false;
+  m_flowStart = Simulator::Now ();
+  m_firstByte = Time ();
+  m_flowAckedBytes = m_ackedBytes;
   ScheduleTransmit (Seconds (0.));
 }
 
@@ -199,6 +431,14 @@ UdpReliableEchoClient::StopApplication ()
     }
 
   Simulator::Cancel (m_sendEvent);
+  Simulator::Cancel (m_timerEvent);
+  Simulator::Cancel (m_reorderEvent);
+  Simulator::Cancel (m_metricsEvent);
+  for (uint32_t i = 1; i < m_streams.size (); i++)
+    {
+      NS_LOG_INFO("Stream " << i << " Messages:" << m_streams[i].message
+                  << " Acked bytes:" << m_streams[i].ackedBytes);
+    }
 }
 
 void 
@@ -215,6 +455,7 @@ UdpReliableEchoClient::SetDataSize (uint32_t dataSize)
   m_data = 0;
   m_dataSize = 0;
   m_size = dataSize;
+  m_payload = Create<Packet> (dataSize);
 }
 
 uint32_t 
@@ -244,6 +485,7 @@ UdpReliableEchoClient::SetFill (std::string fill)
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -263,6 +505,7 @@ UdpReliableEchoClient::SetFill (uint8_t fill, uint32_t dataSize)
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -280,6 +523,7 @@ UdpReliableEchoClient::SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataS
     {
       memcpy (m_data, fill, dataSize);
       m_size = dataSize;
+      m_payload = Create<Packet> (m_data, dataSize);
       return;
     }
 
@@ -302,6 +546,7 @@ UdpReliableEchoClient::SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataS
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -318,30 +563,56 @@ UdpReliableEchoClient::Send (void)
 
   NS_ASSERT (m_sendEvent.IsExpired ());
 
-  Ptr<Packet> p;
-  if (m_dataSize)
+  Time now = Simulator::Now ();
+  uint32_t id = PickStream (now);
+  if (id == m_streams.size ())
     {
-      //
-      // If m_dataSize is non-zero, we have a data buffer of the same size that we
-      // are expected to copy and send.  This state of affairs is created if one of
-      // the Fill functions is called.  In this case, m_size must have been set
-      // to agree with m_dataSize
-      //
-      NS_ASSERT_MSG (m_dataSize == m_size, "UdpReliableEchoClient::Send(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "UdpReliableEchoClient::Send(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
+      // nothing due: wait for the next message of any stream
+      Time next;
+      bool waiting = false;
+      for (uint32_t i = 0; i < m_streams.size (); i++)
+        {
+          if (!IsFinished (i) && (!waiting || m_streams[i].nextMessage < next))
+            {
+              next = m_streams[i].nextMessage;
+              waiting = true;
+            }
+        }
+      if (waiting)
+        {
+          ScheduleTransmit (next - now);
+        }
+      return;
     }
-  else
+
+  Stream &stream = m_streams[id];
+  if (stream.fragments == 0)
     {
-      //
-      // If m_dataSize is zero, the client has indicated that it doesn't care
-      // about the data itself either by specifying the data size by setting
-      // the corresponding attribute or by not calling a SetFill function.  In
-      // this case, we don't worry about it either.  But we do allow m_size
-      // to have a value different from the (zero) m_dataSize.
-      //
-      p = Create<Packet> (m_size);
+      // start the next message
+      stream.messageSize = stream.size;
+      if (id == 0 && m_bulkBytes > 0)
+        {
+          stream.messageSize = static_cast<uint32_t> (std::min<uint64_t> (stream.size, m_bulkBytes - m_bulkQueued));
+        }
+      stream.fragment = 0;
+      stream.fragments = std::max<uint32_t> ((stream.messageSize + m_segmentSize - 1) / m_segmentSize, 1);
     }
+  uint32_t offset = stream.fragment * m_segmentSize;
+  uint32_t size = std::min (m_segmentSize, stream.messageSize - offset);
+  if (!m_window.CanSend (size, GetMaxInFlight ()))
+    {
+      // resumed by Unblock once an echo or an abandoned packet frees room
+      m_blocked = true;
+      m_blockedSize = size;
+      return;
+    }
+
+  //
+  // Fragments are cut from the message template built by SetFill or
+  // SetDataSize; they share its data copy-on-write, so sending neither
+  // allocates nor copies the payload.
+  //
+  Ptr<Packet> p = stream.payload->CreateFragment (offset, size);
   Address localAddress;
   m_socket->GetSockName (localAddress);
   // call to the trace sinks before the packet is actually sent,
@@ -355,11 +626,22 @@ UdpReliableEchoClient::Send (void)
     {
       m_txTraceWithAddresses (p, localAddress, Inet6SocketAddress (Ipv6Address::ConvertFrom (m_peerAddress), m_peerPort));
     }
+  SelectiveRepeatWindow::Entry &entry = m_window.Add (size, Simulator::Now ());
+  seqNumber = m_window.GetNext ();
+  ReliableDataHeader &dataHeader = m_dataHeaders[entry.seq % m_dataHeaders.size ()];
+  dataHeader.SetStream (id);
+  dataHeader.SetMessage (stream.message);
+  dataHeader.SetFragment (stream.fragment, stream.fragments);
+  dataHeader.SetOffset (offset);
+  dataHeader.SetMessageSize (stream.messageSize);
+  p->AddHeader(dataHeader);
   SeqTsHeader seqTs;
-  seqTs.SetSeq(seqNumber++);
+  seqTs.SetSeq(entry.seq);
   p->AddHeader(seqTs);
   m_socket->Send (p);
   ++m_sent;
+  stream.inFlight++;
+  ArmTimer (entry);
   /*
   if (Ipv4Address::IsMatchingType (m_peerAddress))
     {
@@ -383,28 +665,79 @@ UdpReliableEchoClient::Send (void)
     }
     */
 
-  if (m_sent < m_count) 
+  if (++stream.fragment == stream.fragments)
     {
-      ScheduleTransmit (m_interval);
+      stream.fragments = 0;
+      stream.message++;
+      stream.nextMessage = now + stream.interval;
+      if (id == 0 && m_bulkBytes > 0)
+        {
+          m_bulkQueued += stream.messageSize;
+        }
     }
+  ScheduleTransmit (GetSendGap ());
 }
 
-void 
-UdpReliableEchoClient::ReTransmit (uint32_t pktNum)
+uint32_t
+UdpReliableEchoClient::PickStream (Time now)
 {
-  NS_LOG_FUNCTION (this);
+  uint32_t best = m_streams.size ();
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      uint32_t id = (m_nextStream + i) % m_streams.size ();
+      const Stream &stream = m_streams[id];
+      if (IsFinished (id) || (stream.fragments == 0 && stream.nextMessage > now))
+        {
+          continue;
+        }
+      if (best == m_streams.size () || stream.priority < m_streams[best].priority)
+        {
+          best = id;
+        }
+    }
+  if (best != m_streams.size ())
+    {
+      // round robin among streams of equal priority
+      m_nextStream = (best + 1) % m_streams.size ();
+    }
+  return best;
+}
 
-  Ptr<Packet> p;
-  if (m_dataSize)
+bool
+UdpReliableEchoClient::IsFinished (uint32_t id) const
+{
+  const Stream &stream = m_streams[id];
+  if (stream.fragments > 0)
     {
-      NS_ASSERT_MSG (m_dataSize == m_size, "UdpReliableEchoClient::Send(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "UdpReliableEchoClient::Send(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
+      return false;
     }
-  else
+  if (id == 0 && m_bulkBytes > 0)
     {
-      p = Create<Packet> (m_size);
+      return m_bulkQueued >= m_bulkBytes;
     }
+  return stream.count > 0 && stream.message >= stream.count;
+}
+
+UdpReliableEchoClient::Stream &
+UdpReliableEchoClient::GetStream (uint32_t seq)
+{
+  return m_streams[m_dataHeaders[seq % m_dataHeaders.size ()].GetStream ()];
+}
+
+void 
+UdpReliableEchoClient::ReTransmit (uint32_t pktNum)
+{
+  NS_LOG_FUNCTION (this << pktNum);
+
+  SelectiveRepeatWindow::Entry *entry = m_window.Get (pktNum);
+  if (entry == 0)
+    {
+      return;
+    }
+  const ReliableDataHeader &dataHeader = m_dataHeaders[pktNum % m_dataHeaders.size ()];
+
+  Ptr<Packet> p = m_streams[dataHeader.GetStream ()].payload->CreateFragment (dataHeader.GetOffset (),
+                                                                             entry->size);
   Address localAddress;
   m_socket->GetSockName (localAddress);
   // call to the trace sinks before the packet is actually sent,
@@ -418,13 +751,343 @@ UdpReliableEchoClient::ReTransmit (uint32_t pktNum)
     {
       m_txTraceWithAddresses (p, localAddress, Inet6SocketAddress (Ipv6Address::ConvertFrom (m_peerAddress), m_peerPort));
     }
+  p->AddHeader(dataHeader);
   SeqTsHeader seqTs;
   seqTs.SetSeq(pktNum);
   p->AddHeader(seqTs);
   m_socket->Send (p);
   ++m_resent;
+  entry->retries++;
+  entry->lastTx = Simulator::Now ();
+  ArmTimer (*entry);
   NS_LOG_INFO("Packet Retrans:" << pktNum);
 }
+
+void
+UdpReliableEchoClient::ArmTimer (SelectiveRepeatWindow::Entry &entry)
+{
+  Time rto = m_rto;
+  for (uint32_t i = 0; i < m_backoff && rto < m_maxRto; i++)
+    {
+      rto = rto + rto;
+    }
+  entry.deadline = Simulator::Now () + std::min (rto, m_maxRto);
+  m_wheel.Schedule (entry.seq, entry.deadline);
+  if (!m_timerEvent.IsRunning ())
+    {
+      m_timerEvent = Simulator::Schedule (m_granularity, &UdpReliableEchoClient::HandleTimers, this);
+    }
+}
+
+void
+UdpReliableEchoClient::HandleTimers (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<TimerWheel::Timer> expired;
+  m_wheel.Advance (Simulator::Now (), expired);
+  bool timedOut = false;
+  for (uint32_t i = 0; i < expired.size (); i++)
+    {
+      SelectiveRepeatWindow::Entry *entry = m_window.Get (expired[i].id);
+      if (entry == 0 || entry->deadline != expired[i].deadline)
+        {
+          // echoed or rearmed since
+          continue;
+        }
+      if (entry->retries == 0)
+        {
+          NS_LOG_INFO("Packet Loss:" << entry->seq);
+          lossNumber++;
+        }
+      if (entry->retries >= m_maxRetries)
+        {
+          NS_LOG_INFO("Packet Abandoned:" << entry->seq);
+          SelectiveRepeatWindow::Entry abandoned;
+          m_window.Remove (entry->seq, abandoned);
+          GetStream (abandoned.seq).inFlight--;
+          m_abandoned++;
+          continue;
+        }
+      if (!timedOut)
+        {
+          // back off once per round of timeouts, before the retransmissions
+          // are rearmed
+          timedOut = true;
+          m_backoff = std::min<uint32_t> (m_backoff + 1, 16);
+          OnLoss ();
+        }
+      ReTransmit (entry->seq);
+    }
+  if (!m_wheel.IsEmpty ())
+    {
+      m_timerEvent = Simulator::Schedule (m_granularity, &UdpReliableEchoClient::HandleTimers, this);
+    }
+  Unblock ();
+  CheckFlowComplete ();
+}
+
+void
+UdpReliableEchoClient::UpdateRtt (Time sample)
+{
+  NS_LOG_FUNCTION (this << sample);
+  if (m_srtt.Get ().IsZero ())
+    {
+      m_srtt = sample;
+      m_rttvar = sample / 2;
+    }
+  else
+    {
+      // RFC 6298: beta = 1/4, alpha = 1/8
+      Time err = Abs (m_srtt.Get () - sample);
+      m_rttvar = m_rttvar.Get () - m_rttvar.Get () / 4 + err / 4;
+      m_srtt = m_srtt.Get () - m_srtt.Get () / 8 + sample / 8;
+    }
+  Time rto = m_srtt.Get () + std::max (m_granularity, 4 * m_rttvar.Get ());
+  m_rto = std::min (std::max (rto, m_minRto), m_maxRto);
+  m_backoff = 0;
+}
+
+bool
+UdpReliableEchoClient::Acknowledge (uint32_t seq, Time sentAt)
+{
+  SelectiveRepeatWindow::Entry acked;
+  if (!m_window.Remove (seq, acked))
+    {
+      return false;
+    }
+  chkNumber = m_window.GetBase ();
+  m_echoed++;
+  m_ackedBytes += acked.size;
+  Stream &stream = GetStream (seq);
+  stream.inFlight--;
+  stream.ackedBytes += acked.size;
+  if (m_firstByte.IsZero ())
+    {
+      m_firstByte = Simulator::Now ();
+    }
+  if (static_cast<int32_t> (seq - m_highestAcked) > 0)
+    {
+      m_highestAcked = seq;
+    }
+
+  Time rtt;
+  if (acked.retries == 0)
+    {
+      // Karn: the echo of a retransmitted packet is ambiguous
+      if (sentAt.IsStrictlyPositive ())
+        {
+          rtt = Simulator::Now () - sentAt;
+          UpdateRtt (rtt);
+        }
+      sentAt = acked.lastTx;
+    }
+  else if (sentAt.IsStrictlyPositive () && sentAt < acked.lastTx)
+    {
+      // the timestamp is that of an earlier copy: the loss was not one
+      m_spurious++;
+      lossNumber--;
+      NS_LOG_INFO("Spurious Retrans:" << seq);
+      m_spuriousTrace (seq, acked.retries);
+    }
+  else
+    {
+      reNumber++;
+      NS_LOG_INFO("Receive Retrans Packet:" << seq);
+    }
+  if (sentAt > m_rackXmit)
+    {
+      m_rackXmit = sentAt;
+    }
+  m_cc->PktsAcked (acked.size, rtt);
+  m_cwnd = m_cc->GetCwnd ();
+  return true;
+}
+
+void
+UdpReliableEchoClient::HandleAck (const ReliableAckHeader &ack)
+{
+  NS_LOG_FUNCTION (this << ack.GetSeq () << ack.GetCumulativeAck ());
+  if (ack.GetSeq () > lastEchoNumber)
+    {
+      lastEchoNumber = ack.GetSeq ();
+    }
+
+  // only the packet that triggered the ACK has a matching timestamp
+  Acknowledge (ack.GetSeq (), ack.GetTs ());
+  uint32_t next = m_window.GetNext ();
+  for (uint32_t seq = m_window.GetBase (); seq != next; seq++)
+    {
+      if (ack.IsAcked (seq))
+        {
+          Acknowledge (seq, Time ());
+        }
+    }
+
+  if (m_ecn && static_cast<int32_t> (ack.GetCeCount () - m_ceCount) > 0)
+    {
+      m_ceCount = ack.GetCeCount ();
+      // the path marked packets instead of dropping them: back off as on
+      // a loss, once per window
+      if (static_cast<int32_t> (ack.GetSeq () - m_recover) >= 0)
+        {
+          NS_LOG_INFO("ECN Reduction:" << ack.GetSeq ());
+          m_ecnReductions++;
+          OnLoss ();
+        }
+    }
+}
+
+void
+UdpReliableEchoClient::DetectLosses (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_reorderEvent);
+  Time now = Simulator::Now ();
+  Time reorder = m_srtt.Get ().IsZero () ? m_rto.Get () : m_srtt.Get ();
+  reorder = reorder + Seconds (reorder.GetSeconds () * m_reorderWindow);
+
+  std::vector<uint32_t> lost;
+  Time recheck;
+  uint32_t next = m_window.GetNext ();
+  for (uint32_t seq = m_window.GetBase (); seq != next; seq++)
+    {
+      SelectiveRepeatWindow::Entry *entry = m_window.Get (seq);
+      if (entry == 0 || entry->retries > 0)
+        {
+          // retransmissions are left to their deadline
+          continue;
+        }
+      if (m_lossDetection == PACKET_THRESHOLD)
+        {
+          if (static_cast<int32_t> (m_highestAcked - seq) < static_cast<int32_t> (m_reorderThreshold))
+            {
+              break;
+            }
+          lost.push_back (seq);
+        }
+      else if (entry->lastTx < m_rackXmit)
+        {
+          Time lostAt = entry->lastTx + reorder;
+          if (lostAt <= now)
+            {
+              lost.push_back (seq);
+            }
+          else if (recheck.IsZero () || lostAt < recheck)
+            {
+              recheck = lostAt;
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < lost.size (); i++)
+    {
+      NS_LOG_INFO("Packet Loss:" << lost[i]);
+      lossNumber++;
+      if (static_cast<int32_t> (lost[i] - m_recover) >= 0)
+        {
+          OnLoss ();
+        }
+      ReTransmit (lost[i]);
+    }
+  if (!recheck.IsZero ())
+    {
+      // still within the reordering window: look again once it has passed
+      m_reorderEvent = Simulator::Schedule (recheck - now, &UdpReliableEchoClient::DetectLosses, this);
+    }
+}
+
+void
+UdpReliableEchoClient::SampleMetrics (void)
+{
+  NS_LOG_FUNCTION (this);
+  ReliableMetrics metrics;
+  metrics.time = Simulator::Now ();
+  metrics.sent = m_sent;
+  metrics.resent = m_resent;
+  metrics.echoed = m_echoed;
+  metrics.lost = lossNumber;
+  metrics.abandoned = m_abandoned;
+  metrics.inFlight = m_window.GetInFlight ();
+  metrics.inFlightBytes = m_window.GetBytes ();
+  metrics.cwnd = m_cwnd;
+  metrics.goodput = static_cast<uint64_t> ((m_ackedBytes - m_sampledBytes) * 8
+                                           / m_metricsInterval.GetSeconds ());
+  metrics.srtt = m_srtt;
+  metrics.rto = m_rto;
+  m_sampledBytes = m_ackedBytes;
+  m_metricsTrace (metrics);
+  m_metricsEvent = Simulator::Schedule (m_metricsInterval, &UdpReliableEchoClient::SampleMetrics, this);
+}
+
+void
+UdpReliableEchoClient::OnLoss (void)
+{
+  NS_LOG_FUNCTION (this);
+  // losses of packets sent before this one are part of the same event
+  m_recover = m_window.GetNext ();
+  m_cc->OnLoss ();
+  m_cwnd = m_cc->GetCwnd ();
+}
+
+uint32_t
+UdpReliableEchoClient::GetMaxInFlight (void) const
+{
+  if (!m_cc->IsEnabled ())
+    {
+      return m_maxInFlightBytes;
+    }
+  if (m_maxInFlightBytes == 0)
+    {
+      return m_cc->GetCwnd ();
+    }
+  return std::min (m_cc->GetCwnd (), m_maxInFlightBytes);
+}
+
+Time
+UdpReliableEchoClient::GetSendGap (void) const
+{
+  if (!m_cc->IsEnabled () || m_srtt.Get ().IsZero ())
+    {
+      // nothing to pace at before the first round-trip time sample; the
+      // streams are then only held back by their intervals and the window
+      return Time ();
+    }
+  DataRate rate = m_cc->GetPacingRate (m_srtt);
+  SeqTsHeader seqTs;
+  ReliableDataHeader dataHeader;
+  return rate.CalculateBytesTxTime (std::min (m_size, m_segmentSize) + seqTs.GetSerializedSize ()
+                                    + dataHeader.GetSerializedSize ());
+}
+
+void
+UdpReliableEchoClient::CheckFlowComplete (void)
+{
+  // other streams may still have packets out
+  if (m_bulkBytes == 0 || m_flowDone || m_bulkQueued < m_bulkBytes
+      || m_streams[0].inFlight > 0)
+    {
+      return;
+    }
+  m_flowDone = true;
+  Time fct = Simulator::Now () - m_flowStart;
+  Time ttfb = m_firstByte - m_flowStart;
+  uint64_t bytes = m_ackedBytes - m_flowAckedBytes;
+  NS_LOG_INFO("Flow Completion Time:" << fct.GetSeconds () << "s"
+              << " Time To First Byte:" << ttfb.GetSeconds () << "s"
+              << " Goodput:" << (bytes * 8 / fct.GetSeconds () / 1e6) << "Mbps"
+              << " Bytes:" << bytes << "/" << m_bulkBytes);
+  m_flowCompleteTrace (fct, ttfb, bytes);
+}
+
+void
+UdpReliableEchoClient::Unblock (void)
+{
+  if (m_blocked && m_socket != 0 && m_window.CanSend (m_blockedSize, GetMaxInFlight ()))
+    {
+      m_blocked = false;
+      Send ();
+    }
+}
 void
 UdpReliableEchoClient::HandleRead (Ptr<Socket> socket)
 {
@@ -435,28 +1098,27 @@ UdpReliableEchoClient::HandleRead (Ptr<Socket> socket)
   while ((packet = socket->RecvFrom (from)))
     {
         socket->GetSockName (localAddress);
-        SeqTsHeader seqTs;
-        packet->RemoveHeader(seqTs);
-        uint32_t recvNumber = seqTs.GetSeq();
-        if (recvNumber > lastEchoNumber) {
-            lastEchoNumber = recvNumber;
-        }
-        if (recvNumber > chkNumber) {
-            for (uint32_t i=chkNumber; i<recvNumber; i++) {
-                NS_LOG_INFO("Packet Loss:" << i);
-                UdpReliableEchoClient::ReTransmit(i);
-            }
-            lossNumber += recvNumber - chkNumber;
-            chkNumber = recvNumber + 1;
-        } else if (recvNumber < chkNumber) {
-            reNumber++;
-            NS_LOG_INFO("Receive Retrans Packet:" << recvNumber);
+        if (m_ackMode == ACK_SACK) {
+            ReliableAckHeader ack;
+            packet->RemoveHeader(ack);
+            HandleAck (ack);
         } else {
-            chkNumber++;
-        };
+            SeqTsHeader seqTs;
+            packet->RemoveHeader(seqTs);
+            uint32_t recvNumber = seqTs.GetSeq();
+            if (recvNumber > lastEchoNumber) {
+                lastEchoNumber = recvNumber;
+            }
+            if (!Acknowledge (recvNumber, seqTs.GetTs ())) {
+                NS_LOG_LOGIC("Duplicate echo:" << recvNumber);
+            }
+        }
       m_rxTrace (packet);
       m_rxTraceWithAddresses (packet, from, localAddress);
     }
+  DetectLosses ();
+  Unblock ();
+  CheckFlowComplete ();
 }
 
 } // Namespace ns3
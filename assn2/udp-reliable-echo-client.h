@@ -24,6 +24,13 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "selective-repeat-window.h"
+#include "timer-wheel.h"
+#include "reliable-congestion-ops.h"
+#include "reliable-ack-header.h"
+#include "reliable-metrics.h"
+#include "reliable-data-header.h"
 
 namespace ns3 {
 
@@ -35,6 +42,49 @@ class Packet;
  * \brief A Udp Echo client
  *
  * Every packet sent should be returned by the server and received here.
+ *
+ * An echo acknowledges its packet.  Packets not echoed before their
+ * retransmission deadline are sent again, selective-repeat style, up to
+ * MaxRetries times; the deadlines of all outstanding packets share one
+ * timer wheel.  New packets wait while the send window or the in-flight
+ * byte cap is full.
+ *
+ * The retransmission timeout follows the round-trip time measured from
+ * the SeqTsHeader timestamp of every echo (Jacobson/Karels), ignoring
+ * retransmitted packets (Karn), and backs off exponentially on timeouts.
+ *
+ * With AckMode Sack, which must match the server, packets are
+ * acknowledged by ReliableAckHeader instead of their echo.
+ *
+ * Besides its deadline, a packet is taken as lost and sent again once
+ * packets after it are acknowledged: ReorderThreshold packets later with
+ * Packet loss detection, or, with Time loss detection (RACK), a packet
+ * sent after it plus SRTT * (1 + ReorderWindow) since it was sent.  A
+ * retransmitted packet whose original copy is acknowledged afterwards,
+ * as told by the echoed timestamp, counts as a spurious retransmission
+ * rather than a loss.
+ *
+ * A message larger than MaxSegmentSize is sent as fragments of at most
+ * MaxSegmentSize bytes, each with its own sequence number, so a loss
+ * only costs the retransmission of one fragment.
+ *
+ * With BulkBytes set, the client transfers that many bytes as fast as the
+ * send window, congestion window and pacing allow, and reports the flow
+ * completion time, time to first byte and goodput through FlowComplete.
+ *
+ * Messages are sent on streams multiplexed over the one socket and
+ * sequence space.  Stream 0 carries the PacketSize messages above;
+ * AddStream adds more, each with its own message size, interval and
+ * priority.  Each fragment goes to the most urgent stream with data
+ * due, round robin among equal priorities, and the server assembles
+ * every stream on its own, so small urgent messages keep flowing while
+ * a bulk stream waits for its retransmissions.
+ *
+ * With Ecn set, packets are sent ECN-capable (ECT(0)).  A rise in the
+ * count of Congestion Experienced marks returned in the ACKs (AckMode
+ * Sack, with Ecn set on the server too) makes the congestion controller
+ * back off as on a loss, at most once per window, before the bottleneck
+ * has to drop anything.
  */
 class UdpReliableEchoClient : public Application 
 {
@@ -45,6 +95,40 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /// How acknowledged packets reveal the loss of earlier ones
+  enum LossDetection
+  {
+    PACKET_THRESHOLD,  //!< lost once ReorderThreshold later packets are acknowledged
+    TIME_THRESHOLD     //!< lost once a later packet is acknowledged and the reorder window passed
+  };
+
+  /**
+   * TracedCallback signature for spurious retransmissions.
+   *
+   * \param [in] seq The sequence number of the packet.
+   * \param [in] retries The number of times it had been retransmitted.
+   */
+  typedef void (* SpuriousTracedCallback)
+    (uint32_t seq, uint32_t retries);
+
+  /**
+   * TracedCallback signature for periodic metrics.
+   *
+   * \param [in] metrics The sample.
+   */
+  typedef void (* MetricsTracedCallback)
+    (const ReliableMetrics &metrics);
+
+  /**
+   * TracedCallback signature for completed bulk transfers.
+   *
+   * \param [in] fct Time from the application start to the last acknowledgement.
+   * \param [in] ttfb Time from the application start to the first acknowledgement.
+   * \param [in] bytes Payload bytes acknowledged.
+   */
+  typedef void (* FlowCompleteTracedCallback)
+    (Time fct, Time ttfb, uint64_t bytes);
+
   UdpReliableEchoClient ();
 
   virtual ~UdpReliableEchoClient ();
@@ -60,6 +144,15 @@ public:
    * \param addr remote address
    */
   void SetRemote (Address addr);
+  /**
+   * \brief Send one more stream of messages, from the application start.
+   * \param size bytes per message
+   * \param interval time between messages
+   * \param priority lower values are sent first; stream 0 has Priority
+   * \param count messages to send (0 for no limit)
+   * \returns the stream number
+   */
+  uint16_t AddStream (uint32_t size, Time interval, uint32_t priority, uint32_t count = 0);
 
   /**
    * Set the data size of the packet (the number of bytes that are sent as data
@@ -134,6 +227,22 @@ protected:
   virtual void DoDispose (void);
 
 private:
+  /// Messages of one stream
+  struct Stream
+  {
+    uint32_t size; //!< bytes per message
+    Time interval; //!< time between messages (zero: as fast as allowed)
+    uint32_t count; //!< messages to send (0: no limit)
+    uint32_t priority; //!< lower values are sent first
+    uint32_t message; //!< number of the message being sent
+    uint32_t messageSize; //!< bytes of the message being sent
+    uint32_t fragment; //!< next fragment of the message to send
+    uint32_t fragments; //!< fragments of the message (0: none under way)
+    Time nextMessage; //!< earliest start of the next message
+    uint32_t inFlight; //!< packets neither acknowledged nor abandoned
+    uint64_t ackedBytes; //!< payload bytes acknowledged
+    Ptr<Packet> payload; //!< message template fragments are cut from
+  };
 
   virtual void StartApplication (void);
   virtual void StopApplication (void);
@@ -144,10 +253,83 @@ private:
    */
   void ScheduleTransmit (Time dt);
   /**
-   * \brief Send a packet
+   * \brief Send the next fragment of the most urgent stream with data due
    */
   void Send (void);
-  void ReTransmit (uint32_t);
+  /**
+   * \param now the current time
+   * \returns the stream to send the next fragment of, or the number of
+   *          streams if none has data due
+   */
+  uint32_t PickStream (Time now);
+  /**
+   * \param id a stream number
+   * \returns true if the stream has sent all its messages
+   */
+  bool IsFinished (uint32_t id) const;
+  /**
+   * \param seq the sequence number of an outstanding packet
+   * \returns the stream the packet belongs to
+   */
+  Stream &GetStream (uint32_t seq);
+  /**
+   * \brief Send an outstanding packet again and rearm its deadline
+   * \param pktNum the sequence number
+   */
+  void ReTransmit (uint32_t pktNum);
+  /**
+   * \brief Retransmit or abandon the packets whose deadline has passed
+   */
+  void HandleTimers (void);
+  /**
+   * \brief Arm the deadline of an outstanding packet
+   * \param entry the packet
+   */
+  void ArmTimer (SelectiveRepeatWindow::Entry &entry);
+  /**
+   * \brief Send the next packet if the application was held back by a
+   * full window and the window has room again
+   */
+  void Unblock (void);
+  /**
+   * \brief Feed a round-trip time sample to the estimator and update the RTO
+   * \param sample the measured round-trip time
+   */
+  void UpdateRtt (Time sample);
+  /**
+   * \brief Release an outstanding packet that reached the server.
+   * \param seq the sequence number
+   * \param sentAt send time of the copy that got through, or zero if unknown
+   * \returns false if the packet was not outstanding
+   */
+  bool Acknowledge (uint32_t seq, Time sentAt);
+  /**
+   * \brief Retransmit the outstanding packets that later acknowledged
+   * packets show to be lost, and arm the reordering timer if some may be.
+   */
+  void DetectLosses (void);
+  /**
+   * \brief Process a cumulative and selective ACK.
+   * \param ack the header
+   */
+  void HandleAck (const ReliableAckHeader &ack);
+  /**
+   * \brief Report the bulk transfer once its last packet is acknowledged
+   * or abandoned
+   */
+  void CheckFlowComplete (void);
+  /**
+   * \brief Fire the Metrics trace and schedule the next sample
+   */
+  void SampleMetrics (void);
+  /**
+   * \brief Tell the congestion controller about a loss, once per window
+   */
+  void OnLoss (void);
+  /// \returns the payload bytes the window may hold, congestion window included
+  uint32_t GetMaxInFlight (void) const;
+  /// \returns the time to wait before the next packet
+  Time GetSendGap (void) const;
 
   /**
    * \brief Handle a packet reception.
@@ -164,6 +346,7 @@ private:
 
   uint32_t m_dataSize; //!< packet payload size (must be equal to m_size)
   uint8_t *m_data; //!< packet payload data
+  Ptr<Packet> m_payload; //!< stream 0 message template, shared copy-on-write by every packet
 
   uint32_t m_sent; //!< Counter for sent packets
   uint32_t m_resent; //!< Counter for sent packets
@@ -171,6 +354,55 @@ private:
   Address m_peerAddress; //!< Remote peer address
   uint16_t m_peerPort; //!< Remote peer port
   EventId m_sendEvent; //!< Event to send the next packet
+  EventId m_timerEvent; //!< Event advancing the timer wheel
+  SelectiveRepeatWindow m_window; //!< Outstanding packets
+  TimerWheel m_wheel; //!< Retransmission deadlines
+  uint32_t m_windowSize; //!< Largest number of outstanding packets
+  uint32_t m_maxInFlightBytes; //!< Cap on outstanding payload bytes (0: none)
+  uint32_t m_maxRetries; //!< Retransmissions before a packet is abandoned
+  Time m_initialRto; //!< Retransmission timeout before the first RTT sample
+  Time m_minRto; //!< Lower bound of the retransmission timeout
+  Time m_maxRto; //!< Upper bound of the retransmission timeout
+  TracedValue<Time> m_srtt; //!< Smoothed round-trip time
+  TracedValue<Time> m_rttvar; //!< Round-trip time variation
+  TracedValue<Time> m_rto; //!< Retransmission timeout, before backoff
+  uint32_t m_backoff; //!< Timeouts since the last RTT sample
+  ReliableAckMode m_ackMode; //!< How the server acknowledges packets
+  uint32_t m_recover; //!< Losses below this sequence number belong to the last loss event
+  LossDetection m_lossDetection; //!< How acknowledgements reveal losses
+  uint32_t m_reorderThreshold; //!< Packets acknowledged past a lost one
+  double m_reorderWindow; //!< Reordering allowance as a fraction of SRTT
+  uint32_t m_highestAcked; //!< Highest sequence number acknowledged
+  Time m_rackXmit; //!< Latest send time of a copy that got through
+  EventId m_reorderEvent; //!< Recheck of packets within the reordering window
+  uint32_t m_spurious; //!< Retransmissions whose original was delivered
+  bool m_ecn; //!< Send ECN-capable packets and react to CE marks
+  uint32_t m_ceCount; //!< CE marks the server reported so far
+  uint32_t m_ecnReductions; //!< Window reductions caused by CE marks
+  Time m_metricsInterval; //!< Time between Metrics samples (0: none)
+  EventId m_metricsEvent; //!< Next Metrics sample
+  uint32_t m_echoed; //!< Packets acknowledged
+  uint64_t m_ackedBytes; //!< Payload bytes acknowledged
+  uint64_t m_sampledBytes; //!< m_ackedBytes at the previous sample
+  uint64_t m_bulkBytes; //!< Bytes of the bulk transfer (0: none)
+  uint64_t m_bulkQueued; //!< Bytes of the bulk transfer sent at least once
+  bool m_flowDone; //!< Bulk transfer reported
+  Time m_flowStart; //!< Start of the bulk transfer
+  Time m_firstByte; //!< First acknowledgement of the run
+  uint64_t m_flowAckedBytes; //!< m_ackedBytes at the start of the transfer
+  uint32_t m_segmentSize; //!< Largest payload of one packet
+  uint32_t m_priority; //!< Priority of stream 0
+  std::vector<Stream> m_addedStreams; //!< Streams added by AddStream, from 1 on
+  std::vector<Stream> m_streams; //!< All streams, stream 0 first
+  uint32_t m_nextStream; //!< Stream the next scheduling pass starts with
+  std::vector<ReliableDataHeader> m_dataHeaders; //!< Framing of every outstanding packet, by sequence number
+  TypeId m_ccType; //!< Congestion controller to create at start
+  Ptr<ReliableCongestionOps> m_cc; //!< Congestion controller
+  TracedValue<uint32_t> m_cwnd; //!< Congestion window in bytes
+  Time m_granularity; //!< Timer wheel tick
+  bool m_blocked; //!< Send held back by the window
+  uint32_t m_blockedSize; //!< Size of the segment the window held back
+  uint32_t m_abandoned; //!< Packets given up after MaxRetries
   uint32_t seqNumber;
   uint32_t chkNumber;
   uint32_t lossNumber;
@@ -189,6 +421,15 @@ private:
   /// Callbacks for tracing the packet Rx events, includes source and destination addresses
   TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
 
+  /// Callbacks for tracing spurious retransmissions
+  TracedCallback<uint32_t, uint32_t> m_spuriousTrace;
+
+  /// Callbacks for tracing periodic metrics
+  TracedCallback<const ReliableMetrics &> m_metricsTrace;
+
+  /// Callbacks for tracing completed bulk transfers
+  TracedCallback<Time, Time, uint64_t> m_flowCompleteTrace;
+
 };
 
 } // namespace ns3
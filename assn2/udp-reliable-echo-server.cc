@@ -29,14 +29,14 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
 #include "ns3/seq-ts-header.h"
 
 #include "udp-reliable-echo-server.h"
 
 namespace ns3 {
 
-uint32_t curpkt = -1;
-
 NS_LOG_COMPONENT_DEFINE ("UdpReliableEchoServerApplication");
 
 NS_OBJECT_ENSURE_REGISTERED (UdpReliableEchoServer);
@@ -52,17 +52,91 @@ UdpReliableEchoServer::GetTypeId (void)
                    UintegerValue (9),
                    MakeUintegerAccessor (&UdpReliableEchoServer::m_port),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("AckMode",
+                   "Echo every packet whole, or return a cumulative and selective ACK",
+                   EnumValue (ACK_ECHO),
+                   MakeEnumAccessor (&UdpReliableEchoServer::m_ackMode),
+                   MakeEnumChecker (ACK_ECHO, "Echo",
+                                    ACK_SACK, "Sack"))
+    .AddAttribute ("SessionTableSize",
+                   "Initial number of slots of the client session table",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_sessionTableSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ReassemblySlots",
+                   "Fragmented messages assembled at once per client",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_reassemblySlots),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxMessageSize",
+                   "Bytes of the largest fragmented message; one buffer of this size "
+                   "is allocated per slot, and fragments of larger messages are dropped",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_maxMessageSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxStreams",
+                   "Streams assembled per client; messages of higher streams are "
+                   "acknowledged but not delivered",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_maxStreams),
+                   MakeUintegerChecker<uint32_t> (1, 65536))
+    .AddAttribute ("DeliveryBufferBytes",
+                   "Bytes of complete messages a stream may hold back for in-order "
+                   "delivery; beyond them missing messages are given up",
+                   UintegerValue (262144),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_deliveryBufferBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AckEvery",
+                   "In-order packets acknowledged by one ACK (Sack mode)",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&UdpReliableEchoServer::m_ackEvery),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AckDelay",
+                   "Longest time an in-order packet waits for its ACK (Sack mode)",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&UdpReliableEchoServer::m_ackDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("Ecn",
+                   "Count ECN Congestion Experienced marks and return them in the ACKs (Sack mode)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpReliableEchoServer::m_ecn),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Rx", "A packet has been received",
                      MakeTraceSourceAccessor (&UdpReliableEchoServer::m_rxTrace),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("RxWithAddresses", "A packet has been received",
                      MakeTraceSourceAccessor (&UdpReliableEchoServer::m_rxTraceWithAddresses),
                      "ns3::Packet::TwoAddressTracedCallback")
+    .AddTraceSource ("Ack", "An ACK has been sent, with the packets it covers and the delay it added",
+                     MakeTraceSourceAccessor (&UdpReliableEchoServer::m_ackTrace),
+                     "ns3::UdpReliableEchoServer::AckTracedCallback")
+    .AddTraceSource ("Message", "A message has been received whole",
+                     MakeTraceSourceAccessor (&UdpReliableEchoServer::m_messageTrace),
+                     "ns3::UdpReliableEchoServer::MessageTracedCallback")
+    .AddTraceSource ("HolBlocking",
+                     "A message has been delivered, with how long it waited for earlier ones",
+                     MakeTraceSourceAccessor (&UdpReliableEchoServer::m_holTrace),
+                     "ns3::UdpReliableEchoServer::HolBlockingTracedCallback")
+    .AddTraceSource ("DeliveryBuffer",
+                     "Bytes of complete messages held for in-order delivery",
+                     MakeTraceSourceAccessor (&UdpReliableEchoServer::m_bufferedBytes),
+                     "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
 }
 
 UdpReliableEchoServer::UdpReliableEchoServer ()
+  : m_ackMode (ACK_ECHO),
+    m_sessionTableSize (64),
+    m_duplicates (0),
+    m_reassemblySlots (16),
+    m_maxMessageSize (65536),
+    m_oversized (0),
+    m_maxStreams (8),
+    m_deliveryBufferBytes (262144),
+    m_bufferedBytes (0),
+    m_ackEvery (2),
+    m_ecn (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -74,10 +148,19 @@ UdpReliableEchoServer::~UdpReliableEchoServer()
   m_socket6 = 0;
 }
 
+void
+UdpReliableEchoServer::SetDeliveryCallback (Callback<void, const Address &, uint16_t, Ptr<const Packet> > deliver)
+{
+  NS_LOG_FUNCTION (this);
+  m_deliver = deliver;
+}
+
 void
 UdpReliableEchoServer::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_sessions.Init (0);
+  m_deliver = MakeNullCallback<void, const Address &, uint16_t, Ptr<const Packet> > ();
   Application::DoDispose ();
 }
 
@@ -134,6 +217,12 @@ UdpReliableEchoServer::StartApplication (void)
         }
     }
 
+  m_sessions.Init (m_sessionTableSize);
+  m_duplicates = 0;
+  m_oversized = 0;
+  m_bufferedBytes = 0;
+  m_socket->SetIpRecvTos (m_ecn);
+  m_socket6->SetIpRecvTos (m_ecn);
   m_socket->SetRecvCallback (MakeCallback (&UdpReliableEchoServer::HandleRead, this));
   m_socket6->SetRecvCallback (MakeCallback (&UdpReliableEchoServer::HandleRead, this));
 }
@@ -153,6 +242,32 @@ UdpReliableEchoServer::StopApplication ()
       m_socket6->Close ();
       m_socket6->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
     }
+  uint64_t bytes = 0;
+  uint64_t messages = 0;
+  uint64_t evicted = 0;
+  uint64_t skipped = 0;
+  for (uint32_t i = 0; i < m_sessions.GetCapacity (); i++)
+    {
+      ReliableSessionTable::Session *session = m_sessions.At (i);
+      if (session != 0)
+        {
+          Simulator::Cancel (session->ackEvent);
+          bytes += session->bytes;
+          messages += session->messages;
+          for (uint32_t j = 0; j < session->reassembly.size (); j++)
+            {
+              evicted += session->reassembly[j].GetEvicted ();
+            }
+          for (uint32_t j = 0; j < session->delivery.size (); j++)
+            {
+              skipped += session->delivery[j].GetSkipped ();
+            }
+        }
+    }
+  NS_LOG_INFO ("Sessions:" << m_sessions.GetSize () << " Delivered bytes:" << bytes
+               << " Duplicates:" << m_duplicates << " Messages:" << messages
+               << " Messages evicted:" << evicted << " Messages given up:" << skipped
+               << " Oversized fragments:" << m_oversized);
 }
 
 void 
@@ -168,6 +283,12 @@ UdpReliableEchoServer::HandleRead (Ptr<Socket> socket)
       socket->GetSockName (localAddress);
       m_rxTrace (packet);
       m_rxTraceWithAddresses (packet, from, localAddress);
+      bool ce = false;
+      SocketIpTosTag tosTag;
+      if (m_ecn && packet->RemovePacketTag (tosTag))
+        {
+          ce = (tosTag.GetTos () & 0x03) == 0x03;
+        }
       /*
       if (InetSocketAddress::IsMatchingType (from))
         {
@@ -182,19 +303,56 @@ UdpReliableEchoServer::HandleRead (Ptr<Socket> socket)
                        Inet6SocketAddress::ConvertFrom (from).GetPort ());
         }
         */
-      //SeqTsHeader seqTs;
-      //packet->RemoveHeader(seqTs);
-      //uint32_t currentSequenceNumber = seqTs.GetSeq();
-      //NS_LOG_INFO("Recv pkt:" << currentSequenceNumber);
-      //if (currentSequenceNumber != curpkt + 1) {
-      //  SeqTsHeader seqTs;
-      //  seqTs.SetSeq(curpkt + 1);
-      //  packet->AddHeader(seqTs);
-      //  socket->SendTo (packet, 0, from);
-      //  curpkt = currentSequenceNumber;
-      //} else {
-      //    curpkt++;
-      //}
+      SeqTsHeader seqTs;
+      ReliableDataHeader dataHeader;
+      Ptr<Packet> data = packet->Copy ();
+      data->RemoveHeader (seqTs);
+      data->RemoveHeader (dataHeader);
+      ReliableSessionTable::Session &session = m_sessions.Insert (from);
+      bool inOrder = seqTs.GetSeq () == session.window.GetCumulativeAck ();
+      bool fresh = session.window.Receive (seqTs.GetSeq ());
+      if (fresh)
+        {
+          session.received++;
+          session.bytes += data->GetSize ();
+          Deliver (session, dataHeader, data);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Duplicate packet " << seqTs.GetSeq () << " from " << from);
+          session.duplicates++;
+          m_duplicates++;
+        }
+
+      if (ce)
+        {
+          NS_LOG_LOGIC ("CE mark on packet " << seqTs.GetSeq () << " from " << from);
+          session.ceCount++;
+        }
+
+      if (m_ackMode == ACK_SACK)
+        {
+          if (session.pending++ == 0)
+            {
+              session.firstPending = Simulator::Now ();
+            }
+          session.seq = seqTs.GetSeq ();
+          session.ts = seqTs.GetTs ();
+
+          if (!inOrder || !fresh || ce || session.window.GetSack () != 0
+              || session.pending >= m_ackEvery || m_ackDelay.IsZero ())
+            {
+              // the sender needs to hear about holes, duplicates and
+              // congestion now
+              SendAck (socket, from);
+            }
+          else if (!session.ackEvent.IsRunning ())
+            {
+              session.ackEvent = Simulator::Schedule (m_ackDelay, &UdpReliableEchoServer::SendAck,
+                                                      this, socket, from);
+            }
+          continue;
+        }
 
       packet->RemoveAllPacketTags ();
       packet->RemoveAllByteTags ();
@@ -218,4 +376,96 @@ UdpReliableEchoServer::HandleRead (Ptr<Socket> socket)
     }
 }
 
+void
+UdpReliableEchoServer::Deliver (ReliableSessionTable::Session &session, const ReliableDataHeader &header,
+                                Ptr<const Packet> data)
+{
+  uint16_t stream = header.GetStream ();
+  if (stream >= m_maxStreams)
+    {
+      NS_LOG_LOGIC ("Stream " << stream << " of " << session.peer << " beyond MaxStreams");
+      return;
+    }
+  Ptr<const Packet> message = data;
+  if (header.GetFragments () > 1)
+    {
+      if (header.GetMessageSize () > m_maxMessageSize)
+        {
+          // the reassembly slot could not hold it
+          NS_LOG_LOGIC ("Message " << header.GetMessage () << " of " << session.peer << " has "
+                        << header.GetMessageSize () << " bytes, beyond MaxMessageSize");
+          m_oversized++;
+          return;
+        }
+      if (session.reassembly.size () <= stream)
+        {
+          session.reassembly.resize (stream + 1);
+        }
+      MessageReassemblyBuffer &reassembly = session.reassembly[stream];
+      if (!reassembly.IsInit ())
+        {
+          reassembly.Init (m_reassemblySlots, m_maxMessageSize);
+        }
+      if (reassembly.Insert (header.GetMessage (), header.GetFragment (), header.GetFragments (),
+                             header.GetOffset (), data) != MessageReassemblyBuffer::COMPLETE)
+        {
+          return;
+        }
+      message = Create<Packet> (reassembly.GetData (header.GetMessage ()), header.GetMessageSize ());
+    }
+  NS_LOG_LOGIC ("Message " << header.GetMessage () << " of stream " << stream << ", "
+                << header.GetMessageSize () << " bytes from " << session.peer);
+  session.messages++;
+  m_messageTrace (session.peer, stream, header.GetMessage (), header.GetMessageSize ());
+  DeliverInOrder (session, stream, header.GetMessage (), message);
+}
+
+void
+UdpReliableEchoServer::DeliverInOrder (ReliableSessionTable::Session &session, uint16_t stream,
+                                       uint32_t message, Ptr<const Packet> data)
+{
+  while (session.delivery.size () <= stream)
+    {
+      session.delivery.push_back (InOrderDeliveryBuffer ());
+      session.delivery.back ().Init (m_deliveryBufferBytes);
+    }
+  InOrderDeliveryBuffer &delivery = session.delivery[stream];
+  uint32_t held = delivery.GetBytes ();
+  delivery.Insert (message, data, Simulator::Now ());
+
+  InOrderDeliveryBuffer::Message next;
+  while (delivery.Pop (next))
+    {
+      m_holTrace (stream, Simulator::Now () - next.arrival);
+      if (!m_deliver.IsNull ())
+        {
+          m_deliver (session.peer, stream, next.data);
+        }
+    }
+  m_bufferedBytes = m_bufferedBytes - held + delivery.GetBytes ();
+}
+
+void
+UdpReliableEchoServer::SendAck (Ptr<Socket> socket, Address from)
+{
+  NS_LOG_FUNCTION (this << socket << from);
+  ReliableSessionTable::Session *session = m_sessions.Find (from);
+  NS_ASSERT (session != 0);
+  Simulator::Cancel (session->ackEvent);
+
+  ReliableAckHeader ack;
+  ack.SetSeq (session->seq);
+  ack.SetTs (session->ts);
+  ack.SetCumulativeAck (session->window.GetCumulativeAck ());
+  ack.SetSack (session->window.GetSack ());
+  ack.SetCeCount (session->ceCount);
+  Ptr<Packet> reply = Create<Packet> ();
+  reply->AddHeader (ack);
+  NS_LOG_LOGIC ("Acknowledging " << session->pending << " packets up to " << session->seq);
+  socket->SendTo (reply, 0, from);
+
+  m_ackTrace (session->pending, Simulator::Now () - session->firstPending);
+  session->pending = 0;
+}
+
 } // Namespace ns3
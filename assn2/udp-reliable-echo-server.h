@@ -24,6 +24,12 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+#include "reliable-ack-header.h"
+#include "reliable-session-table.h"
+#include "reliable-data-header.h"
 
 namespace ns3 {
 
@@ -40,6 +46,32 @@ class Packet;
  * \brief A Udp Echo server
  *
  * Every packet received is sent back.
+ *
+ * The server keeps a session per client in a ReliableSessionTable, with
+ * the sequence numbers received, so retransmissions that were not needed
+ * are counted as duplicates and left out of the delivered bytes.
+ *
+ * Fragments of messages larger than the client's MaxSegmentSize are
+ * copied into preallocated per-client buffers until the message is whole.
+ * Each stream of a client has its own buffers and message numbers, so a
+ * stream waiting for a retransmission holds up no other.
+ *
+ * Complete messages are passed to the delivery callback in order, per
+ * stream.  A message completing before an earlier one is held in an
+ * InOrderDeliveryBuffer of at most DeliveryBufferBytes; the HolBlocking
+ * trace reports how long each message was held and DeliveryBuffer the
+ * bytes held over all clients.
+ *
+ * With AckMode Sack the payload is not returned: every packet is
+ * answered with a ReliableAckHeader alone.  ACKs of in-order packets are coalesced: one
+ * goes out every AckEvery packets or AckDelay after the first packet it
+ * covers, whichever comes first.  Packets out of order, duplicates and
+ * packets arriving while holes remain are acknowledged at once.
+ *
+ * With Ecn set, the server reads the ECN field of every packet and the
+ * ACK returns the count of Congestion Experienced marks; a packet with
+ * a mark is acknowledged at once.  Echo mode has no room for the count,
+ * so ECN feedback needs AckMode Sack.
  */
 class UdpReliableEchoServer : public Application 
 {
@@ -49,9 +81,46 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for coalesced acknowledgements.
+   *
+   * \param [in] packets The number of packets the ACK is the first to cover.
+   * \param [in] delay How long the oldest of them waited for the ACK.
+   */
+  typedef void (* AckTracedCallback)
+    (uint32_t packets, Time delay);
+
+  /**
+   * TracedCallback signature for messages received whole.
+   *
+   * \param [in] from The client socket address.
+   * \param [in] stream The stream of the message.
+   * \param [in] message The message number within the stream.
+   * \param [in] size The message size in bytes.
+   */
+  typedef void (* MessageTracedCallback)
+    (const Address &from, uint16_t stream, uint32_t message, uint32_t size);
+
+  /**
+   * TracedCallback signature for head-of-line blocking.
+   *
+   * \param [in] stream The stream of the message.
+   * \param [in] delay How long the complete message waited for earlier ones.
+   */
+  typedef void (* HolBlockingTracedCallback)
+    (uint16_t stream, Time delay);
+
   UdpReliableEchoServer ();
   virtual ~UdpReliableEchoServer ();
 
+  /**
+   * \brief Set the callback messages are delivered to, in order per stream.
+   * \param deliver called with the client socket address, the stream and
+   *        the message payload
+   */
+  void SetDeliveryCallback (Callback<void, const Address &, uint16_t, Ptr<const Packet> > deliver);
+
 protected:
   virtual void DoDispose (void);
 
@@ -69,16 +138,63 @@ private:
    */
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \brief Pass a new fragment to its message, reporting the message once whole.
+   * \param session the client session
+   * \param header the framing of the fragment
+   * \param data the fragment payload
+   */
+  void Deliver (ReliableSessionTable::Session &session, const ReliableDataHeader &header,
+                Ptr<const Packet> data);
+  /**
+   * \brief Hold a complete message and deliver every message now in order.
+   * \param session the client session
+   * \param stream the stream of the message
+   * \param message the message number
+   * \param data the message payload
+   */
+  void DeliverInOrder (ReliableSessionTable::Session &session, uint16_t stream,
+                       uint32_t message, Ptr<const Packet> data);
+  /**
+   * \brief Send the ACK of a client now, cancelling its delayed ACK timer.
+   * \param socket the socket the client's packets arrive on
+   * \param from the client's socket address
+   */
+  void SendAck (Ptr<Socket> socket, Address from);
+
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   Ptr<Socket> m_socket; //!< IPv4 Socket
   Ptr<Socket> m_socket6; //!< IPv6 Socket
   Address m_local; //!< local multicast address
+  ReliableAckMode m_ackMode; //!< how received packets are acknowledged
+  ReliableSessionTable m_sessions; //!< state of every client
+  uint32_t m_sessionTableSize; //!< initial slots of m_sessions
+  uint32_t m_duplicates; //!< packets received more than once, over all clients
+  uint32_t m_reassemblySlots; //!< fragmented messages assembled at once per client
+  uint32_t m_maxMessageSize; //!< bytes of the largest fragmented message
+  uint32_t m_oversized; //!< fragments of larger messages dropped, over all clients
+  uint32_t m_maxStreams; //!< streams assembled per client
+  uint32_t m_deliveryBufferBytes; //!< bytes a stream may hold back for in-order delivery
+  Callback<void, const Address &, uint16_t, Ptr<const Packet> > m_deliver; //!< in-order delivery
+  TracedValue<uint32_t> m_bufferedBytes; //!< bytes held for in-order delivery, over all clients
+  uint32_t m_ackEvery; //!< in-order packets covered by one ACK
+  Time m_ackDelay; //!< longest time an in-order packet waits for its ACK
+  bool m_ecn; //!< read and return ECN marks
 
   /// Callbacks for tracing the packet Rx events
   TracedCallback<Ptr<const Packet> > m_rxTrace;
 
   /// Callbacks for tracing the packet Rx events, includes source and destination addresses
   TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
+
+  /// Callbacks for tracing ACKs sent
+  TracedCallback<uint32_t, Time> m_ackTrace;
+
+  /// Callbacks for tracing messages received whole
+  TracedCallback<const Address &, uint16_t, uint32_t, uint32_t> m_messageTrace;
+
+  /// Callbacks for tracing how long messages waited for earlier ones
+  TracedCallback<uint16_t, Time> m_holTrace;
 };
 
 } // namespace ns3
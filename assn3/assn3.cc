@@ -1,4 +1,5 @@
 #include "streaming-helper.h"
+#include "streaming-streamer.h"
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -8,6 +9,9 @@
 #include "ns3/mobility-module.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/yans-wifi-phy.h"
+#include <chrono>
+#include <sstream>
+#include <cstdlib>
 
 //custom
 
@@ -15,6 +19,21 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("assn3");
 
+static double wallClockTotal = 0; //!< wall-clock ms spent on the simulated seconds so far
+static uint32_t wallClockSeconds = 0; //!< simulated seconds measured
+
+// the wall-clock time the simulator took for the last simulated second
+static void
+WallClockTick (std::chrono::steady_clock::time_point last)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - last).count();
+    wallClockTotal += ms;
+    wallClockSeconds++;
+    std::cout << "Simulated second " << wallClockSeconds << ": " << ms << " ms wall-clock" << '\n';
+    Simulator::Schedule (Seconds (1.0), &WallClockTick, now);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -22,10 +41,32 @@ main (int argc, char *argv[])
     LogComponentEnable("StreamingClientApplication", LOG_LEVEL_INFO);
 
     uint32_t payloadSize = 1472;
+    std::string pacing = "Burst";
+    std::string traceFile = "";
+    std::string fec = "None";
+    uint32_t parity = 4;
+    double nackInterval = 0;
+    uint32_t nClients = 1;
+    std::string scheduler = "RoundRobin";
+    std::string weights = "";
+    bool wallClock = false;
+
+    CommandLine cmd;
+    cmd.AddValue ("pacing", "Streamer pacing mode (Burst, Paced or TokenBucket)", pacing);
+    cmd.AddValue ("trace", "Frame size trace for the streamer (empty for fixed-size frames)", traceFile);
+    cmd.AddValue ("fec", "FEC scheme protecting every frame (None, Xor or ReedSolomon)", fec);
+    cmd.AddValue ("parity", "Parity packets added to every frame", parity);
+    cmd.AddValue ("nack", "Client NACK interval in ms (0 for no NACKs)", nackInterval);
+    cmd.AddValue ("clients", "Number of STA clients served by the streamer", nClients);
+    cmd.AddValue ("scheduler", "Streamer session scheduler (RoundRobin or Weighted)", scheduler);
+    cmd.AddValue ("weights", "Comma-separated session weights of the clients, in order, "
+                  "for the Weighted scheduler (missing ones are 1)", weights);
+    cmd.AddValue ("wallclock", "Print the wall-clock time taken per simulated second", wallClock);
+    cmd.Parse (argc, argv);
 
     // 1. Create Nodes STA and AP
     NodeContainer wifiStaNode;
-    wifiStaNode.Create(1);
+    wifiStaNode.Create(nClients);
     NodeContainer wifiApNode;
     wifiApNode.Create(1);
 
@@ -82,7 +123,10 @@ main (int argc, char *argv[])
     Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
 
     positionAlloc->Add (Vector (0.0, 0.0, 0.0));
-    positionAlloc->Add (Vector (1.0, 0.0, 0.0));
+    for (uint32_t i = 0; i < nClients; i++)
+    {
+        positionAlloc->Add (Vector (1.0, 0.0, 0.0));
+    }
     mobility.SetPositionAllocator (positionAlloc);
 
     mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
@@ -102,19 +146,31 @@ main (int argc, char *argv[])
     echoStreamer.SetAttribute("Interval", TimeValue(Seconds((double)(1.0/90))));
     echoStreamer.SetAttribute("PacketSize", UintegerValue(payloadSize));
     echoStreamer.SetAttribute("ReceivePort", UintegerValue(udp_port2));
+    echoStreamer.SetAttribute("PacingMode", StringValue(pacing));
+    echoStreamer.SetAttribute("TraceFile", StringValue(traceFile));
+    echoStreamer.SetAttribute("FecScheme", StringValue(fec));
+    echoStreamer.SetAttribute("FecParityPackets", UintegerValue(parity));
+    echoStreamer.SetAttribute("Scheduler", StringValue(scheduler));
     ApplicationContainer streamerApp = echoStreamer.Install(wifiApNode.Get(0));
+    // weighted clients are known up front instead of joining with weight 1
+    std::istringstream weightList(weights);
+    std::string weight;
+    for (uint32_t i = 0; i < nClients && std::getline(weightList, weight, ','); i++) {
+        DynamicCast<StreamingStreamer>(streamerApp.Get(0))->AddSession(StaInterface.GetAddress(i), std::atoi(weight.c_str()));
+    }
     streamerApp.Start(Seconds(0.0));
     streamerApp.Stop(Seconds(10.0));
 
 
     StreamingClientHelper echoClient(udp_port);
     echoClient.SetAttribute("ConsumeInterval", TimeValue(Seconds((double)(1.0/60))));
-    echoClient.SetAttribute("GenerateInterval", TimeValue(Seconds((double)(1.0/20))));
     echoClient.SetAttribute("PacketSize", UintegerValue(payloadSize));
     echoClient.SetAttribute("RemoteAddress", AddressValue(ApInterface.GetAddress(0)));
     echoClient.SetAttribute("RemotePort", UintegerValue(udp_port2));
+    echoClient.SetAttribute("NackInterval", TimeValue(Seconds(nackInterval / 1000.0)));
 
-    ApplicationContainer clientApp = echoClient.Install(wifiStaNode.Get(0));
+    // the other clients join the streamer with their first control packet
+    ApplicationContainer clientApp = echoClient.Install(wifiStaNode);
     clientApp.Start(Seconds(0.0));
     clientApp.Stop(Seconds(10.0));
 
@@ -133,7 +189,14 @@ main (int argc, char *argv[])
 
     // 9. Simulation Run and calc throughput
     Simulator::Stop(Seconds(10.0));
+    if (wallClock) {
+        Simulator::Schedule (Seconds (1.0), &WallClockTick, std::chrono::steady_clock::now());
+    }
     Simulator::Run ();
+    if (wallClockSeconds > 0) {
+        std::cout << "Mean wall-clock per simulated second: "
+                  << wallClockTotal / wallClockSeconds << " ms" << '\n';
+    }
     Simulator::Destroy ();
 
     //uint32_t totalPacketsRecv = DynamicCast<UdpServer> (serverApp.Get(0))->GetReceived();
@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include <algorithm>
+#include <cstring>
+#include "fec-codec.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FecCodec");
+
+/**
+ * \brief dst ^= src over a whole block, a machine word at a time
+ * \param dst destination block
+ * \param src source block
+ * \param size block size
+ */
+static void
+XorBlock (uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+  uint32_t i = 0;
+  for (; i + sizeof (uint64_t) <= size; i += sizeof (uint64_t))
+    {
+      uint64_t a, b;
+      std::memcpy (&a, dst + i, sizeof (a));
+      std::memcpy (&b, src + i, sizeof (b));
+      a ^= b;
+      std::memcpy (dst + i, &a, sizeof (a));
+    }
+  for (; i < size; i++)
+    {
+      dst[i] ^= src[i];
+    }
+}
+
+FecCodec::~FecCodec ()
+{
+}
+
+bool
+FecCodec::IsReceived (const uint64_t *received, uint32_t i)
+{
+  return (received[i / 64] >> (i % 64)) & 1;
+}
+
+void
+XorFecCodec::Encode (const std::vector<uint8_t *> &blocks, uint32_t n, uint32_t k,
+                     uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << n << k << size);
+  for (uint32_t j = 0; j < k; j++)
+    {
+      std::memset (blocks[n + j], 0, size);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      XorBlock (blocks[n + i % k], blocks[i], size);
+    }
+}
+
+bool
+XorFecCodec::CanRecover (const uint64_t *received, uint32_t n, uint32_t k) const
+{
+  for (uint32_t j = 0; j < k; j++)
+    {
+      uint32_t missing = IsReceived (received, n + j) ? 0 : 1;
+      for (uint32_t i = j; i < n && missing < 2; i += k)
+        {
+          missing += IsReceived (received, i) ? 0 : 1;
+        }
+      if (missing > 1)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+XorFecCodec::Decode (const std::vector<uint8_t *> &blocks, const uint64_t *received,
+                     uint32_t n, uint32_t k, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << n << k << size);
+  if (!CanRecover (received, n, k))
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < k; j++)
+    {
+      uint32_t lost = n;
+      for (uint32_t i = j; i < n; i += k)
+        {
+          if (!IsReceived (received, i))
+            {
+              lost = i;
+            }
+        }
+      if (lost == n)
+        {
+          continue;
+        }
+      std::memcpy (blocks[lost], blocks[n + j], size);
+      for (uint32_t i = j; i < n; i += k)
+        {
+          if (i != lost)
+            {
+              XorBlock (blocks[lost], blocks[i], size);
+            }
+        }
+    }
+  return true;
+}
+
+bool
+XorFecCodec::Supports (uint32_t n, uint32_t k) const
+{
+  // every block needs its own 16-bit packet index
+  return k > 0 && k <= n && n + k <= 65535;
+}
+
+ReedSolomonFecCodec::ReedSolomonFecCodec ()
+{
+  NS_LOG_FUNCTION (this);
+  // GF(2^8) with the primitive polynomial x^8 + x^4 + x^3 + x^2 + 1
+  uint32_t x = 1;
+  for (uint32_t i = 0; i < 255; i++)
+    {
+      m_exp[i] = x;
+      m_exp[i + 255] = x;
+      m_log[x] = i;
+      x <<= 1;
+      if (x & 0x100)
+        {
+          x ^= 0x11d;
+        }
+    }
+  m_exp[510] = m_exp[0];
+  m_exp[511] = m_exp[1];
+  m_log[0] = 0;
+  m_inv[0] = 0;
+  for (uint32_t i = 1; i < 256; i++)
+    {
+      m_inv[i] = m_exp[255 - m_log[i]];
+    }
+}
+
+uint8_t
+ReedSolomonFecCodec::Coefficient (uint32_t j, uint32_t i, uint32_t k) const
+{
+  // Cauchy matrix 1 / (x_j + y_i) with x_j = j and y_i = k + i: every
+  // square submatrix is invertible, so any n blocks rebuild the frame
+  return m_inv[j ^ (k + i)];
+}
+
+void
+ReedSolomonFecCodec::MulAdd (uint8_t *dst, const uint8_t *src, uint8_t c, uint32_t size) const
+{
+  if (c == 0)
+    {
+      return;
+    }
+  if (c == 1)
+    {
+      XorBlock (dst, src, size);
+      return;
+    }
+  uint8_t row[256];
+  const uint8_t *exp = m_exp + m_log[c];
+  row[0] = 0;
+  for (uint32_t v = 1; v < 256; v++)
+    {
+      row[v] = exp[m_log[v]];
+    }
+  for (uint32_t i = 0; i < size; i++)
+    {
+      dst[i] ^= row[src[i]];
+    }
+}
+
+void
+ReedSolomonFecCodec::Encode (const std::vector<uint8_t *> &blocks, uint32_t n, uint32_t k,
+                             uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << n << k << size);
+  NS_ASSERT_MSG (Supports (n, k), "ReedSolomonFecCodec::Encode(): too many blocks");
+  for (uint32_t j = 0; j < k; j++)
+    {
+      std::memset (blocks[n + j], 0, size);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          MulAdd (blocks[n + j], blocks[i], Coefficient (j, i, k), size);
+        }
+    }
+}
+
+bool
+ReedSolomonFecCodec::CanRecover (const uint64_t *received, uint32_t n, uint32_t k) const
+{
+  uint32_t count = 0;
+  for (uint32_t w = 0; w < (n + k + 63) / 64; w++)
+    {
+      count += __builtin_popcountll (received[w]);
+    }
+  return count >= n;
+}
+
+bool
+ReedSolomonFecCodec::Decode (const std::vector<uint8_t *> &blocks, const uint64_t *received,
+                             uint32_t n, uint32_t k, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << n << k << size);
+  std::vector<uint32_t> lost;
+  std::vector<uint32_t> parity;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (!IsReceived (received, i))
+        {
+          lost.push_back (i);
+        }
+    }
+  for (uint32_t j = 0; j < k && parity.size () < lost.size (); j++)
+    {
+      if (IsReceived (received, n + j))
+        {
+          parity.push_back (j);
+        }
+    }
+  uint32_t m = lost.size ();
+  if (m == 0)
+    {
+      return true;
+    }
+  if (parity.size () < m)
+    {
+      return false;
+    }
+
+  // syndromes: what the chosen parity blocks owe to the lost data blocks
+  std::vector<std::vector<uint8_t> > syndrome (m, std::vector<uint8_t> (size));
+  for (uint32_t r = 0; r < m; r++)
+    {
+      uint8_t *s = &syndrome[r][0];
+      std::memcpy (s, blocks[n + parity[r]], size);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (IsReceived (received, i))
+            {
+              MulAdd (s, blocks[i], Coefficient (parity[r], i, k), size);
+            }
+        }
+    }
+
+  // invert the m x m Cauchy submatrix by Gauss-Jordan elimination
+  std::vector<uint8_t> a (m * m);
+  std::vector<uint8_t> inv (m * m, 0);
+  for (uint32_t r = 0; r < m; r++)
+    {
+      for (uint32_t c = 0; c < m; c++)
+        {
+          a[r * m + c] = Coefficient (parity[r], lost[c], k);
+        }
+      inv[r * m + r] = 1;
+    }
+  for (uint32_t c = 0; c < m; c++)
+    {
+      uint32_t pivot = c;
+      while (a[pivot * m + c] == 0)
+        {
+          pivot++;
+        }
+      for (uint32_t x = 0; x < m; x++)
+        {
+          std::swap (a[c * m + x], a[pivot * m + x]);
+          std::swap (inv[c * m + x], inv[pivot * m + x]);
+        }
+      uint8_t scale = m_inv[a[c * m + c]];
+      for (uint32_t x = 0; x < m; x++)
+        {
+          if (a[c * m + x])
+            {
+              a[c * m + x] = m_exp[m_log[a[c * m + x]] + m_log[scale]];
+            }
+          if (inv[c * m + x])
+            {
+              inv[c * m + x] = m_exp[m_log[inv[c * m + x]] + m_log[scale]];
+            }
+        }
+      for (uint32_t r = 0; r < m; r++)
+        {
+          uint8_t f = a[r * m + c];
+          if (r == c || f == 0)
+            {
+              continue;
+            }
+          for (uint32_t x = 0; x < m; x++)
+            {
+              if (a[c * m + x])
+                {
+                  a[r * m + x] ^= m_exp[m_log[a[c * m + x]] + m_log[f]];
+                }
+              if (inv[c * m + x])
+                {
+                  inv[r * m + x] ^= m_exp[m_log[inv[c * m + x]] + m_log[f]];
+                }
+            }
+        }
+    }
+
+  for (uint32_t c = 0; c < m; c++)
+    {
+      std::memset (blocks[lost[c]], 0, size);
+      for (uint32_t r = 0; r < m; r++)
+        {
+          MulAdd (blocks[lost[c]], &syndrome[r][0], inv[c * m + r], size);
+        }
+    }
+  return true;
+}
+
+bool
+ReedSolomonFecCodec::Supports (uint32_t n, uint32_t k) const
+{
+  return k > 0 && n + k <= 256;
+}
+
+Ptr<FecCodec>
+MakeFecCodec (FecScheme scheme)
+{
+  switch (scheme)
+    {
+    case FEC_XOR:
+      return Create<XorFecCodec> ();
+    case FEC_REED_SOLOMON:
+      return Create<ReedSolomonFecCodec> ();
+    default:
+      return 0;
+    }
+}
+
+} // namespace ns3
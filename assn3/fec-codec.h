@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FEC_CODEC_H
+#define FEC_CODEC_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+/// Frame-level forward error correction schemes
+enum FecScheme
+{
+  FEC_NONE = 0,         //!< no parity packets
+  FEC_XOR = 1,          //!< one XOR parity packet per interleaved group
+  FEC_REED_SOLOMON = 2  //!< systematic Reed-Solomon over GF(2^8)
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Erasure code protecting the n data packets of a frame with k
+ *        parity packets
+ *
+ * Blocks 0..n-1 are the data packets and blocks n..n+k-1 the parity
+ * packets, all padded to the same size.  Which blocks arrived is given as
+ * a bitmap with one bit per block, as kept by FrameReassemblyBuffer.
+ *
+ * The block loops work a machine word at a time and have no dependency
+ * between iterations, so the compiler is free to vectorize them.
+ */
+class FecCodec : public SimpleRefCount<FecCodec>
+{
+public:
+  virtual ~FecCodec ();
+
+  /**
+   * \brief Compute the parity blocks of a frame.
+   * \param blocks n data blocks followed by k parity blocks to fill
+   * \param n number of data blocks
+   * \param k number of parity blocks
+   * \param size size of every block in bytes
+   */
+  virtual void Encode (const std::vector<uint8_t *> &blocks, uint32_t n, uint32_t k,
+                       uint32_t size) const = 0;
+
+  /**
+   * \param received one bit per block, set if the block arrived
+   * \param n number of data blocks
+   * \param k number of parity blocks
+   * \returns true if every missing data block can be rebuilt
+   */
+  virtual bool CanRecover (const uint64_t *received, uint32_t n, uint32_t k) const = 0;
+
+  /**
+   * \brief Rebuild the missing data blocks in place.
+   * \param blocks n data blocks followed by k parity blocks
+   * \param received one bit per block, set if the block arrived
+   * \param n number of data blocks
+   * \param k number of parity blocks
+   * \param size size of every block in bytes
+   * \returns false if too many blocks are missing
+   */
+  virtual bool Decode (const std::vector<uint8_t *> &blocks, const uint64_t *received,
+                       uint32_t n, uint32_t k, uint32_t size) const = 0;
+
+  /**
+   * \param n number of data blocks
+   * \param k number of parity blocks
+   * \returns true if the code can protect n data blocks with k parity blocks
+   */
+  virtual bool Supports (uint32_t n, uint32_t k) const = 0;
+
+protected:
+  /**
+   * \param received one bit per block
+   * \param i block index
+   * \returns true if block i arrived
+   */
+  static bool IsReceived (const uint64_t *received, uint32_t i);
+};
+
+/**
+ * \ingroup udpecho
+ * \brief XOR parity: data block i belongs to group i % k and parity block
+ *        n + j is the XOR of group j
+ *
+ * Each group survives the loss of any one of its blocks.  n + k may not
+ * exceed 65535, the range of the packet index.
+ */
+class XorFecCodec : public FecCodec
+{
+public:
+  virtual void Encode (const std::vector<uint8_t *> &blocks, uint32_t n, uint32_t k,
+                       uint32_t size) const;
+  virtual bool CanRecover (const uint64_t *received, uint32_t n, uint32_t k) const;
+  virtual bool Decode (const std::vector<uint8_t *> &blocks, const uint64_t *received,
+                       uint32_t n, uint32_t k, uint32_t size) const;
+  virtual bool Supports (uint32_t n, uint32_t k) const;
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Systematic Reed-Solomon code built on a Cauchy matrix over GF(2^8)
+ *
+ * Any n of the n + k blocks rebuild the frame.  n + k may not exceed 256.
+ */
+class ReedSolomonFecCodec : public FecCodec
+{
+public:
+  ReedSolomonFecCodec ();
+
+  virtual void Encode (const std::vector<uint8_t *> &blocks, uint32_t n, uint32_t k,
+                       uint32_t size) const;
+  virtual bool CanRecover (const uint64_t *received, uint32_t n, uint32_t k) const;
+  virtual bool Decode (const std::vector<uint8_t *> &blocks, const uint64_t *received,
+                       uint32_t n, uint32_t k, uint32_t size) const;
+  virtual bool Supports (uint32_t n, uint32_t k) const;
+
+private:
+  /**
+   * \param j parity block
+   * \param i data block
+   * \param k number of parity blocks
+   * \returns the coefficient of data block i in parity block j
+   */
+  uint8_t Coefficient (uint32_t j, uint32_t i, uint32_t k) const;
+  /**
+   * \brief dst ^= c * src over a whole block
+   * \param dst destination block
+   * \param src source block
+   * \param c GF(2^8) coefficient
+   * \param size block size
+   */
+  void MulAdd (uint8_t *dst, const uint8_t *src, uint8_t c, uint32_t size) const;
+
+  uint8_t m_exp[512]; //!< antilog table, doubled to skip a modulo
+  uint8_t m_log[256]; //!< log table
+  uint8_t m_inv[256]; //!< multiplicative inverses
+};
+
+/**
+ * \param scheme the FEC scheme
+ * \returns a codec for the scheme, or a null pointer for FEC_NONE
+ */
+Ptr<FecCodec> MakeFecCodec (FecScheme scheme);
+
+} // namespace ns3
+
+#endif /* FEC_CODEC_H */
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include <algorithm>
+#include "frame-reassembly-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FrameReassemblyBuffer");
+
+FrameReassemblyBuffer::FrameReassemblyBuffer ()
+  : m_words (0),
+    m_maxPackets (0),
+    m_frames (0),
+    m_bytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FrameReassemblyBuffer::Init (uint32_t window, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << window << maxPackets);
+  NS_ASSERT_MSG (window > 0, "FrameReassemblyBuffer::Init(): empty window");
+  m_maxPackets = maxPackets;
+  m_words = (maxPackets + 63) / 64;
+  Slot empty = { 0, 0, 0, 0, 0, 0, Time (), FREE };
+  m_slots.assign (window, empty);
+  m_bitmap.assign (window * m_words, 0);
+  m_frames = 0;
+  m_bytes = 0;
+}
+
+uint64_t *
+FrameReassemblyBuffer::Bitmap (uint32_t slot)
+{
+  return &m_bitmap[slot * m_words];
+}
+
+void
+FrameReassemblyBuffer::Fill (const Slot &slot, FrameInfo &info)
+{
+  info.frame = slot.frame;
+  info.received = slot.received;
+  info.dataReceived = slot.dataReceived;
+  info.expected = slot.expected;
+  info.highest = slot.highest;
+  info.bytes = slot.bytes;
+  info.firstTx = slot.firstTx;
+}
+
+FrameReassemblyBuffer::InsertResult
+FrameReassemblyBuffer::Insert (uint32_t frame, uint32_t index, uint32_t count,
+                               uint32_t parity, uint32_t bytes, Time txTime)
+{
+  NS_LOG_FUNCTION (this << frame << index << count << parity << bytes << txTime);
+  NS_ASSERT_MSG (index < count + parity && count + parity <= m_maxPackets,
+                 "FrameReassemblyBuffer::Insert(): packet index out of range");
+
+  uint32_t n = frame % m_slots.size ();
+  Slot &slot = m_slots[n];
+  uint64_t *bitmap = Bitmap (n);
+  if (slot.state != FREE && slot.frame != frame)
+    {
+      if (frame < slot.frame)
+        {
+          return STALE;
+        }
+      if (slot.state == ASSEMBLING)
+        {
+          return CONFLICT;
+        }
+    }
+  else if (slot.state == DONE)
+    {
+      return DUPLICATE;
+    }
+  if (slot.state != ASSEMBLING)
+    {
+      slot.frame = frame;
+      slot.expected = count;
+      slot.received = 0;
+      slot.dataReceived = 0;
+      slot.highest = 0;
+      slot.bytes = 0;
+      slot.firstTx = txTime;
+      slot.state = ASSEMBLING;
+      std::fill (bitmap, bitmap + m_words, 0);
+      m_frames++;
+    }
+
+  uint64_t mask = uint64_t (1) << (index % 64);
+  uint64_t &word = bitmap[index / 64];
+  if (word & mask)
+    {
+      return DUPLICATE;
+    }
+  word |= mask;
+  slot.received++;
+  slot.highest = std::max (slot.highest, index);
+  slot.bytes += bytes;
+  m_bytes += bytes;
+  if (txTime < slot.firstTx)
+    {
+      slot.firstTx = txTime;
+    }
+  if (index < slot.expected && ++slot.dataReceived >= slot.expected)
+    {
+      return COMPLETE;
+    }
+  return PARTIAL;
+}
+
+void
+FrameReassemblyBuffer::Release (uint32_t frame)
+{
+  NS_LOG_FUNCTION (this << frame);
+  Slot &slot = m_slots[frame % m_slots.size ()];
+  if (slot.state == ASSEMBLING && slot.frame == frame)
+    {
+      slot.state = DONE;
+      m_frames--;
+      m_bytes -= slot.bytes;
+    }
+}
+
+const uint64_t *
+FrameReassemblyBuffer::GetBitmap (uint32_t frame) const
+{
+  uint32_t n = frame % m_slots.size ();
+  const Slot &slot = m_slots[n];
+  if (slot.state != ASSEMBLING || slot.frame != frame)
+    {
+      return 0;
+    }
+  return &m_bitmap[n * m_words];
+}
+
+bool
+FrameReassemblyBuffer::GetOccupant (uint32_t frame, FrameInfo &info) const
+{
+  const Slot &slot = m_slots[frame % m_slots.size ()];
+  if (slot.state != ASSEMBLING)
+    {
+      return false;
+    }
+  Fill (slot, info);
+  return true;
+}
+
+bool
+FrameReassemblyBuffer::GetOldest (FrameInfo &info) const
+{
+  const Slot *oldest = 0;
+  for (uint32_t i = 0; i < m_slots.size (); i++)
+    {
+      if (m_slots[i].state == ASSEMBLING && (oldest == 0 || m_slots[i].frame < oldest->frame))
+        {
+          oldest = &m_slots[i];
+        }
+    }
+  if (oldest == 0)
+    {
+      return false;
+    }
+  Fill (*oldest, info);
+  return true;
+}
+
+uint32_t
+FrameReassemblyBuffer::GetReceived (uint32_t frame) const
+{
+  const Slot &slot = m_slots[frame % m_slots.size ()];
+  if (slot.state == ASSEMBLING && slot.frame == frame)
+    {
+      return slot.received;
+    }
+  return 0;
+}
+
+uint32_t
+FrameReassemblyBuffer::GetWindow (void) const
+{
+  return m_slots.size ();
+}
+
+uint32_t
+FrameReassemblyBuffer::GetMaxPackets (void) const
+{
+  return m_maxPackets;
+}
+
+uint32_t
+FrameReassemblyBuffer::GetFrames (void) const
+{
+  return m_frames;
+}
+
+uint32_t
+FrameReassemblyBuffer::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+} // namespace ns3
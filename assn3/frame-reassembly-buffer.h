@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FRAME_REASSEMBLY_BUFFER_H
+#define FRAME_REASSEMBLY_BUFFER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Fixed-capacity ring of per-frame reassembly slots
+ *
+ * Frame f lives in slot f % window.  Each slot only records which packets
+ * of the frame have arrived (one bit per packet) and how many there are,
+ * so the memory used is O(window) and every packet costs O(1), whatever
+ * the frame rate.  The packets themselves are not kept.
+ *
+ * A frame may be followed by FEC parity packets, indexed after its data
+ * packets.  A released frame keeps its slot until a newer frame needs it,
+ * so packets still arriving for it are recognized and ignored.
+ */
+class FrameReassemblyBuffer
+{
+public:
+  /// Outcome of inserting one packet
+  enum InsertResult
+  {
+    STALE,      //!< frame is older than the one currently owning the slot
+    CONFLICT,   //!< slot owned by an older frame, which must be evicted first
+    DUPLICATE,  //!< packet already received, or its frame already released
+    PARTIAL,    //!< packet recorded, frame still incomplete
+    COMPLETE    //!< packet recorded and all data packets are in
+  };
+
+  /// Summary of a frame held in the ring
+  struct FrameInfo
+  {
+    uint32_t frame;     //!< frame index
+    uint32_t received;  //!< distinct packets received, parity included
+    uint32_t dataReceived; //!< distinct data packets received
+    uint32_t expected;  //!< data packets in the frame
+    uint32_t highest;   //!< highest packet index received
+    uint32_t bytes;     //!< payload bytes received
+    Time firstTx;       //!< earliest send time of a received packet
+  };
+
+  FrameReassemblyBuffer ();
+
+  /**
+   * \brief Allocate the ring, dropping any state it held.
+   * \param window number of frame slots
+   * \param maxPackets largest number of packets a frame may have, parity
+   *        included
+   */
+  void Init (uint32_t window, uint32_t maxPackets);
+
+  /**
+   * \brief Record the arrival of one packet.
+   *
+   * A packet of a frame newer than the one currently owning the slot is
+   * refused with CONFLICT; the caller decides whether to evict the owner
+   * (see GetOccupant) and insert again.
+   *
+   * \param frame frame index
+   * \param index packet index inside the frame
+   * \param count number of data packets in the frame
+   * \param parity number of parity packets following the data packets
+   * \param bytes payload size of the packet
+   * \param txTime time the packet was sent
+   * \returns what happened to the packet
+   */
+  InsertResult Insert (uint32_t frame, uint32_t index, uint32_t count,
+                       uint32_t parity, uint32_t bytes, Time txTime);
+
+  /**
+   * \brief Stop assembling a frame and free its budget.
+   * \param frame frame index
+   */
+  void Release (uint32_t frame);
+
+  /**
+   * \param frame frame index
+   * \returns the received-packet bitmap of a frame being assembled, or
+   *          a null pointer
+   */
+  const uint64_t *GetBitmap (uint32_t frame) const;
+
+  /**
+   * \brief Get the frame currently owning the slot a frame maps to.
+   * \param frame frame index
+   * \param info filled with the owner of the slot
+   * \returns false if the slot is free
+   */
+  bool GetOccupant (uint32_t frame, FrameInfo &info) const;
+
+  /**
+   * \brief Get the oldest frame held in the ring.
+   *
+   * This scans the whole ring; it is meant for eviction, not for the
+   * per-packet path.
+   *
+   * \param info filled with the oldest frame
+   * \returns false if the ring is empty
+   */
+  bool GetOldest (FrameInfo &info) const;
+
+  /**
+   * \param frame frame index
+   * \returns the number of distinct packets received for the frame
+   */
+  uint32_t GetReceived (uint32_t frame) const;
+
+  /// \returns the number of frame slots
+  uint32_t GetWindow (void) const;
+
+  /// \returns the largest number of packets a frame may have
+  uint32_t GetMaxPackets (void) const;
+
+  /// \returns the number of frames held in the ring
+  uint32_t GetFrames (void) const;
+
+  /// \returns the payload bytes of all frames held in the ring
+  uint32_t GetBytes (void) const;
+
+private:
+  /// Slot life cycle
+  enum State
+  {
+    FREE,        //!< never used
+    ASSEMBLING,  //!< frame being received
+    DONE         //!< frame released, slot kept to filter late packets
+  };
+
+  /// Per-frame metadata
+  struct Slot
+  {
+    uint32_t frame;     //!< frame owning the slot
+    uint32_t expected;  //!< data packets in the frame
+    uint32_t received;  //!< popcount of the slot bitmap
+    uint32_t dataReceived; //!< popcount of the data part of the bitmap
+    uint32_t highest;   //!< highest packet index received
+    uint32_t bytes;     //!< payload bytes received
+    Time firstTx;       //!< earliest send time of a received packet
+    State state;        //!< slot life cycle
+  };
+
+  /**
+   * \param slot a slot
+   * \param info filled from the slot
+   */
+  static void Fill (const Slot &slot, FrameInfo &info);
+
+  /**
+   * \param slot slot number
+   * \returns first bitmap word of the slot
+   */
+  uint64_t *Bitmap (uint32_t slot);
+
+  std::vector<Slot> m_slots;        //!< ring of slots
+  std::vector<uint64_t> m_bitmap;   //!< m_words bitmap words per slot
+  uint32_t m_words;                 //!< bitmap words per slot
+  uint32_t m_maxPackets;            //!< largest number of packets in a frame
+  uint32_t m_frames;                //!< slots currently assembling
+  uint32_t m_bytes;                 //!< bytes over all owned slots
+};
+
+} // namespace ns3
+
+#endif /* FRAME_REASSEMBLY_BUFFER_H */
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#include "frame-size-trace.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FrameSizeTrace");
+
+/// Magic number opening a binary trace
+static const char g_binaryMagic[4] = { 'F', 'S', 'T', '1' };
+
+FrameSizeTrace::FrameSizeTrace ()
+  : m_data (0),
+    m_length (0),
+    m_cursor (0),
+    m_binary (false),
+    m_maxFrameSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FrameSizeTrace::~FrameSizeTrace ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+FrameSizeTrace::Open (std::string path, uint32_t maxFrameSize)
+{
+  NS_LOG_FUNCTION (this << path << maxFrameSize);
+  Close ();
+  m_maxFrameSize = maxFrameSize;
+
+  int fd = open (path.c_str (), O_RDONLY);
+  if (fd == -1)
+    {
+      NS_LOG_WARN ("Cannot open frame size trace " << path);
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) == -1 || st.st_size == 0)
+    {
+      close (fd);
+      return false;
+    }
+  void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid once the descriptor is closed
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Cannot map frame size trace " << path);
+      return false;
+    }
+  madvise (data, st.st_size, MADV_SEQUENTIAL);
+  m_data = static_cast<const uint8_t *> (data);
+  m_length = st.st_size;
+
+  m_binary = m_length >= sizeof (g_binaryMagic)
+    && std::memcmp (m_data, g_binaryMagic, sizeof (g_binaryMagic)) == 0;
+
+  // make sure there is at least one usable frame so that Next () terminates
+  m_cursor = m_binary ? sizeof (g_binaryMagic) : 0;
+  uint32_t size;
+  while (m_binary ? m_cursor + 4 <= m_length : m_cursor < m_length)
+    {
+      uint64_t frame = m_cursor;
+      if (m_binary ? ReadBinary (size) : ParseLine (size))
+        {
+          m_cursor = frame;
+          return true;
+        }
+    }
+  NS_LOG_ERROR ("No usable frame size in trace " << path);
+  Close ();
+  return false;
+}
+
+void
+FrameSizeTrace::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_length);
+    }
+  m_data = 0;
+  m_length = 0;
+  m_cursor = 0;
+}
+
+bool
+FrameSizeTrace::IsOpen (void) const
+{
+  return m_data != 0;
+}
+
+uint32_t
+FrameSizeTrace::Next (void)
+{
+  NS_ASSERT_MSG (IsOpen (), "FrameSizeTrace::Next(): no trace open");
+  uint32_t size;
+  if (m_binary)
+    {
+      while (true)
+        {
+          if (m_cursor + 4 > m_length)
+            {
+              m_cursor = sizeof (g_binaryMagic);
+            }
+          if (ReadBinary (size))
+            {
+              return size;
+            }
+        }
+    }
+
+  while (true)
+    {
+      if (m_cursor >= m_length)
+        {
+          m_cursor = 0;
+        }
+      if (ParseLine (size))
+        {
+          return size;
+        }
+    }
+}
+
+bool
+FrameSizeTrace::ReadBinary (uint32_t &size)
+{
+  uint64_t offset = m_cursor;
+  const uint8_t *p = m_data + m_cursor;
+  m_cursor += 4;
+  size = uint32_t (p[0]) | (uint32_t (p[1]) << 8)
+         | (uint32_t (p[2]) << 16) | (uint32_t (p[3]) << 24);
+  return CheckSize (size, offset);
+}
+
+bool
+FrameSizeTrace::CheckSize (uint64_t size, uint64_t offset) const
+{
+  if (size > m_maxFrameSize)
+    {
+      NS_LOG_ERROR ("Frame size " << size << " at offset " << offset
+                    << " exceeds the largest frame of " << m_maxFrameSize
+                    << " bytes; frame skipped");
+      return false;
+    }
+  return true;
+}
+
+bool
+FrameSizeTrace::ParseLine (uint32_t &size)
+{
+  while (m_cursor < m_length && (m_data[m_cursor] == ' ' || m_data[m_cursor] == '\t'))
+    {
+      m_cursor++;
+    }
+  uint64_t offset = m_cursor;
+  bool found = false;
+  uint64_t value = 0;
+  if (m_cursor < m_length && m_data[m_cursor] != '#')
+    {
+      while (m_cursor < m_length && m_data[m_cursor] >= '0' && m_data[m_cursor] <= '9')
+        {
+          // saturate rather than wrap so that huge values fail the check
+          value = std::min<uint64_t> (value * 10 + (m_data[m_cursor] - '0'), UINT64_C (1) << 32);
+          found = true;
+          m_cursor++;
+        }
+    }
+  while (m_cursor < m_length && m_data[m_cursor++] != '\n')
+    {
+    }
+  if (!found || !CheckSize (value, offset))
+    {
+      return false;
+    }
+  size = static_cast<uint32_t> (value);
+  return true;
+}
+
+} // namespace ns3
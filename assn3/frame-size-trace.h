@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FRAME_SIZE_TRACE_H
+#define FRAME_SIZE_TRACE_H
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Sequential reader of a video frame-size trace
+ *
+ * The file is memory-mapped and read one frame at a time, so only the
+ * pages being read are resident however large the trace is.  When the
+ * end of the trace is reached, reading starts over from the first frame.
+ *
+ * Two formats are accepted:
+ * - text: one frame size in bytes per line; empty lines and lines
+ *   starting with '#' are skipped
+ * - binary: the four bytes "FST1" followed by one little-endian 32-bit
+ *   frame size per frame
+ *
+ * Frame sizes above the maximum given to Open are reported as errors and
+ * skipped.
+ */
+class FrameSizeTrace
+{
+public:
+  FrameSizeTrace ();
+  ~FrameSizeTrace ();
+
+  /**
+   * \brief Map a trace file, closing any file already open.
+   * \param path the trace file
+   * \param maxFrameSize the largest frame size accepted, in bytes
+   * \returns false if the file cannot be mapped or holds no usable frame
+   */
+  bool Open (std::string path, uint32_t maxFrameSize);
+
+  /// \brief Unmap the trace file.
+  void Close (void);
+
+  /// \returns true if a trace file is mapped
+  bool IsOpen (void) const;
+
+  /**
+   * \brief Read the size of the next frame.
+   * \returns the frame size in bytes
+   */
+  uint32_t Next (void);
+
+private:
+  /// Copying would unmap the file twice
+  FrameSizeTrace (const FrameSizeTrace &);
+  /// Copying would unmap the file twice
+  FrameSizeTrace &operator= (const FrameSizeTrace &);
+
+  /**
+   * \brief Parse the text line starting at m_cursor.
+   * \param size set to the frame size if the line holds one
+   * \returns true if the line held a frame size
+   */
+  bool ParseLine (uint32_t &size);
+  /**
+   * \brief Read the binary frame size at m_cursor.
+   * \param size set to the frame size if it is within range
+   * \returns true if the frame size is within range
+   */
+  bool ReadBinary (uint32_t &size);
+  /**
+   * \brief Check a frame size against m_maxFrameSize.
+   * \param size the frame size
+   * \param offset where the frame size starts in the file
+   * \returns true if the frame size is within range
+   */
+  bool CheckSize (uint64_t size, uint64_t offset) const;
+
+  const uint8_t *m_data; //!< start of the mapping
+  uint64_t m_length; //!< length of the mapping
+  uint64_t m_cursor; //!< offset of the next frame
+  bool m_binary; //!< binary format
+  uint32_t m_maxFrameSize; //!< largest frame size accepted
+};
+
+} // namespace ns3
+
+#endif /* FRAME_SIZE_TRACE_H */
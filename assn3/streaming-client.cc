@@ -29,8 +29,10 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
-#include "ns3/seq-ts-header.h"
+#include "ns3/trace-source-accessor.h"
+#include "streaming-header.h"
 #include <map>
+#include <algorithm>
 #include <stdlib.h>
 
 #include "streaming-client.h"
@@ -65,11 +67,6 @@ StreamingClient::GetTypeId (void)
                    TimeValue (Seconds (1.0)),
                    MakeTimeAccessor (&StreamingClient::interval_consumer),
                    MakeTimeChecker ())
-    .AddAttribute ("GenerateInterval",
-                   "Interval between consuming frames",
-                   TimeValue (Seconds (1.0)),
-                   MakeTimeAccessor (&StreamingClient::interval_generator),
-                   MakeTimeChecker ())
     .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
                    UintegerValue (100),
                    MakeUintegerAccessor (&StreamingClient::SetDataSize,
@@ -85,6 +82,63 @@ StreamingClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&StreamingClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("ReassemblyWindow",
+                   "Number of frames that can be reassembled at the same time",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&StreamingClient::m_window),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxPacketsPerFrame",
+                   "Largest number of packets a frame may have, parity included",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&StreamingClient::m_maxPacketsPerFrame),
+                   MakeUintegerChecker<uint32_t> (1, 65535))
+    .AddAttribute ("EvictionDeadline",
+                   "Number of frames an incomplete frame may lag behind the "
+                   "frame being consumed before it is evicted (0 for no deadline)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&StreamingClient::m_evictionDeadline),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxBufferBytes",
+                   "Payload bytes incomplete frames may hold (0 for no limit)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&StreamingClient::m_maxBufferBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxBufferFrames",
+                   "Number of incomplete frames that may be held "
+                   "(0 for no limit besides ReassemblyWindow)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&StreamingClient::m_maxBufferFrames),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NackInterval",
+                   "Time between rounds of NACKs for missing packets (0 for no NACKs)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&StreamingClient::m_nackInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("ReportInterval",
+                   "Time between receiver reports; a report is also sent at start "
+                   "and whenever the client pauses or resumes the streamer "
+                   "(0 for no periodic reports)",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&StreamingClient::m_reportInterval),
+                   MakeTimeChecker ())
+    .AddTraceSource ("FrameComplete", "All packets of a frame have been received",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameCompleteTrace),
+                     "ns3::StreamingClient::FrameCompleteTracedCallback")
+    .AddTraceSource ("FrameRecovered", "A frame has been completed from FEC parity packets",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameRecoveredTrace),
+                     "ns3::StreamingClient::FrameRecoveredTracedCallback")
+    .AddTraceSource ("FrameEvicted", "An incomplete frame has been evicted",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameEvictedTrace),
+                     "ns3::StreamingClient::FrameEvictedTracedCallback")
+    .AddTraceSource ("Nack", "Missing packets of a frame have been NACKed",
+                     MakeTraceSourceAccessor (&StreamingClient::m_nackTrace),
+                     "ns3::StreamingClient::NackTracedCallback")
+    .AddTraceSource ("NackSkipped", "An incomplete frame is too close to its deadline to be repaired",
+                     MakeTraceSourceAccessor (&StreamingClient::m_nackSkippedTrace),
+                     "ns3::StreamingClient::NackTracedCallback")
+    .AddTraceSource ("BufferBytes", "Payload bytes held by incomplete frames",
+                     MakeTraceSourceAccessor (&StreamingClient::m_bufferBytes),
+                     "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
 }
@@ -93,12 +147,21 @@ StreamingClient::StreamingClient ()
 {
   NS_LOG_FUNCTION (this);
   curFrame = 0;
-  packet_buffer.clear();
+  m_lastFrame = 0;
+  m_paused = false;
+  m_framesReceived = 0;
+  m_framesLost = 0;
+  m_packetsReceived = 0;
+  m_packetsLost = 0;
   frame_buffer.clear();
+  m_bufferBytes = 0;
   m_data = 0;
   m_dataSize = 0;
   m_consumeEvent = EventId();
-  m_generateEvent = EventId();
+  for (uint32_t i = 0; i <= FEC_REED_SOLOMON; i++)
+    {
+      m_codecs[i] = MakeFecCodec (static_cast<FecScheme> (i));
+    }
 }
 
 StreamingClient::~StreamingClient()
@@ -147,6 +210,8 @@ StreamingClient::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
+  packet_buffer.Init (m_window, m_maxPacketsPerFrame);
+
   if (m_socket == 0)
     {
       TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
@@ -243,8 +308,13 @@ StreamingClient::StartApplication (void)
 
   m_socket->SetRecvCallback (MakeCallback (&StreamingClient::HandleRead, this));
   m_socket6->SetRecvCallback (MakeCallback (&StreamingClient::HandleRead, this));
-  ScheduleGenerator (Seconds (0.));
   ScheduleConsumer (Seconds (0.));
+  // the first report also opens our session at the streamer
+  m_reportEvent = Simulator::ScheduleNow (&StreamingClient::SendReport, this);
+  if (m_nackInterval.IsStrictlyPositive ())
+    {
+      m_nackEvent = Simulator::Schedule (m_nackInterval, &StreamingClient::SendNacks, this);
+    }
 }
 
 void 
@@ -263,7 +333,8 @@ StreamingClient::StopApplication ()
       m_socket6->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
     }
   Simulator::Cancel (m_consumeEvent);
-  Simulator::Cancel (m_generateEvent);
+  Simulator::Cancel (m_nackEvent);
+  Simulator::Cancel (m_reportEvent);
 }
 
 void 
@@ -297,19 +368,85 @@ StreamingClient::HandleRead (Ptr<Socket> socket)
       //                 Inet6SocketAddress::ConvertFrom (from).GetPort ());
       //  }
 
-      SeqTsHeader seqTs;
+      StreamingHeader header;
       packet->RemoveAllPacketTags ();
       packet->RemoveAllByteTags ();
-      packet->RemoveHeader(seqTs);
-      uint32_t currentSequenceNumber = seqTs.GetSeq();
-      //NS_LOG_INFO(currentSequenceNumber);
-      uint32_t frame_index = currentSequenceNumber / 100;
-      uint32_t seq_pkt_number = currentSequenceNumber - 100 * frame_index;
-      if ( packet_buffer.find(frame_index) == packet_buffer.end() ) {
-          std::map <uint32_t, Ptr<Packet>> frame_tmp;
-          packet_buffer.insert({frame_index, frame_tmp});
+      packet->RemoveHeader(header);
+      if (header.GetVersion () > StreamingHeader::VERSION
+          || (header.GetType () != StreamingHeader::DATA
+              && header.GetType () != StreamingHeader::PARITY))
+        {
+          NS_LOG_LOGIC ("Ignoring packet " << header);
+          continue;
         }
-      packet_buffer.at(frame_index).insert({seq_pkt_number, packet});
+      uint32_t frame_index = header.GetFrame ();
+      uint32_t seq_pkt_number = header.GetPacketIndex ();
+      uint32_t packet_count = header.GetPacketCount ();
+      uint32_t parity = header.GetParityCount ();
+      Ptr<FecCodec> codec;
+      if (header.GetFecScheme () <= FEC_REED_SOLOMON)
+        {
+          codec = m_codecs[header.GetFecScheme ()];
+        }
+      if (seq_pkt_number >= packet_count + parity
+          || packet_count + parity > m_maxPacketsPerFrame)
+        {
+          NS_LOG_LOGIC ("Frame " << frame_index << " larger than MaxPacketsPerFrame");
+          continue;
+        }
+      if (m_evictionDeadline != 0 && frame_index + m_evictionDeadline < curFrame)
+        {
+          NS_LOG_LOGIC ("Late packet of frame " << frame_index);
+          continue;
+        }
+      Time delay = Simulator::Now () - header.GetTs ();
+      m_delay = m_delay.IsZero () ? delay : m_delay + (delay - m_delay) / 8;
+      if (!m_lastTransit.IsZero ())
+        {
+          m_jitter = m_jitter + (Abs (delay - m_lastTransit) - m_jitter) / 16;
+        }
+      m_lastTransit = delay;
+      m_lastFrame = std::max (m_lastFrame, frame_index);
+      uint32_t bytes = packet->GetSize ();
+      FrameReassemblyBuffer::InsertResult result = packet_buffer.Insert (frame_index, seq_pkt_number, packet_count,
+                                                                         parity, bytes, header.GetTs ());
+      if (result == FrameReassemblyBuffer::CONFLICT)
+        {
+          FrameReassemblyBuffer::FrameInfo occupant;
+          packet_buffer.GetOccupant (frame_index, occupant);
+          Evict (occupant);
+          result = packet_buffer.Insert (frame_index, seq_pkt_number, packet_count,
+                                         parity, bytes, header.GetTs ());
+        }
+      if (result == FrameReassemblyBuffer::PARTIAL && codec != 0 && parity > 0
+          && packet_buffer.GetReceived (frame_index) >= packet_count)
+        {
+          FrameReassemblyBuffer::FrameInfo info;
+          packet_buffer.GetOccupant (frame_index, info);
+          if (codec->CanRecover (packet_buffer.GetBitmap (frame_index), packet_count, parity))
+            {
+              m_frameRecoveredTrace (frame_index, packet_count - info.dataReceived);
+              m_packetsLost += packet_count - info.dataReceived;
+              result = FrameReassemblyBuffer::COMPLETE;
+            }
+        }
+      if (result == FrameReassemblyBuffer::PARTIAL || result == FrameReassemblyBuffer::COMPLETE)
+        {
+          m_packetsReceived++;
+        }
+      if (result == FrameReassemblyBuffer::COMPLETE)
+        {
+          m_framesReceived++;
+          FrameReassemblyBuffer::FrameInfo info;
+          packet_buffer.GetOccupant (frame_index, info);
+          m_frameCompleteTrace (frame_index, Simulator::Now () - info.firstTx);
+          Generate (frame_index);
+        }
+      if (IsOverBudget ())
+        {
+          EnforceBufferLimits ();
+        }
+      m_bufferBytes = packet_buffer.GetBytes ();
       NS_LOG_LOGIC ("Echoing packet");
       //m_from = from;
       //r_socket = socket;
@@ -330,6 +467,7 @@ StreamingClient::Consume (void)
     if (frame_buffer.find(curFrame) == frame_buffer.end())
     {
         NS_LOG_INFO("FrameConsumerLog::NoConsume");
+        m_framesLost++;
     }
     else
     {
@@ -338,74 +476,152 @@ StreamingClient::Consume (void)
     }
     uint32_t remain_frame = (uint32_t)frame_buffer.size();
     NS_LOG_INFO("FrameConsumerLog::RemainFrames: " + std::to_string(remain_frame));
-    SeqTsHeader seqTs;
-    Ptr<Packet> packet = Create<Packet> (m_size);
-    packet->RemoveAllPacketTags ();
-    packet->RemoveAllByteTags ();
-    packet->RemoveHeader(seqTs);
-    uint32_t seqNum;
+    bool paused = m_paused;
     if (remain_frame > 30)
     {
-        seqNum = -1;
-        seqTs.SetSeq(seqNum);
-        packet->AddHeader(seqTs);
-        //r_socket->SendTo (packet, 0, m_peerAddress);
-        r_socket->Send (packet);
+        paused = true;
     }
     else if (remain_frame < 5)
     {
-        seqNum = -2;
-        seqTs.SetSeq(seqNum);
-        packet->AddHeader(seqTs);
-        //r_socket->SendTo (packet, 0, m_peerAddress);
-        r_socket->Send (packet);
+        paused = false;
+    }
+    if (paused != m_paused)
+    {
+        m_paused = paused;
+        Simulator::Cancel (m_reportEvent);
+        SendReport ();
     }
     curFrame++;
+    EnforceBufferLimits ();
+    m_bufferBytes = packet_buffer.GetBytes ();
 
     ScheduleConsumer (interval_consumer);
     return;
 }
-void 
-StreamingClient::ScheduleGenerator (Time dt)
+void
+StreamingClient::Generate (uint32_t frame_index)
 {
-  NS_LOG_FUNCTION (this << dt);
-  m_consumeEvent = Simulator::Schedule (dt, &StreamingClient::Generate, this);
+    NS_LOG_FUNCTION (this << frame_index);
+    if (frame_buffer.size() < 40 && frame_index >= curFrame)
+    {
+        frame_buffer.insert({frame_index, frame_index});
+    }
+    packet_buffer.Release (frame_index);
 }
 
 void
-StreamingClient::Generate (void)
+StreamingClient::Evict (const FrameReassemblyBuffer::FrameInfo &info)
 {
-    uint8_t delete_flag;
-    for (auto iter = packet_buffer.cbegin(); iter != packet_buffer.cend();)
+  NS_LOG_FUNCTION (this << info.frame);
+  NS_LOG_LOGIC ("Evicting frame " << info.frame << " with " << info.received << " packets");
+  packet_buffer.Release (info.frame);
+  m_packetsLost += info.expected - std::min (info.dataReceived, info.expected);
+  m_frameEvictedTrace (info.frame, info.received, info.bytes);
+}
+
+bool
+StreamingClient::IsOverBudget (void) const
+{
+  if (m_maxBufferBytes != 0 && packet_buffer.GetBytes () > m_maxBufferBytes)
     {
-        delete_flag = 0;
-        uint32_t frame_index = iter->first;
-        std::map <uint32_t, Ptr<Packet>> frame_tmp;
-        frame_tmp = iter->second;
-        if (frame_tmp.size() >= 100)
+      return true;
+    }
+  return m_maxBufferFrames != 0 && packet_buffer.GetFrames () > m_maxBufferFrames;
+}
+
+void
+StreamingClient::EnforceBufferLimits (void)
+{
+  FrameReassemblyBuffer::FrameInfo oldest;
+  while (packet_buffer.GetOldest (oldest)
+         && ((m_evictionDeadline != 0 && oldest.frame + m_evictionDeadline < curFrame)
+             || IsOverBudget ()))
+    {
+      Evict (oldest);
+    }
+}
+
+void
+StreamingClient::SendNacks (void)
+{
+  NS_LOG_FUNCTION (this);
+  // a repair costs the NACK trip plus the retransmission trip
+  Time repair = m_delay + m_delay;
+  Time untilConsume = Simulator::GetDelayLeft (m_consumeEvent);
+  for (uint32_t frame = curFrame; frame <= m_lastFrame; frame++)
+    {
+      FrameReassemblyBuffer::FrameInfo info;
+      if (!packet_buffer.GetOccupant (frame, info) || info.frame != frame)
         {
-            if (frame_buffer.size() >= 40 || frame_index < curFrame)
-            {
-                frame_tmp.clear();
-                delete_flag = 1;
-            }
-            else
+          continue;
+        }
+      std::map<uint32_t, Time>::iterator last = m_nacked.find (frame);
+      if (last != m_nacked.end () && Simulator::Now () < last->second + repair)
+        {
+          // the previous repair may still be on its way
+          continue;
+        }
+      // packets after the highest one received may still be in flight,
+      // unless a newer frame has started arriving
+      uint32_t end = frame < m_lastFrame ? info.expected : std::min (info.highest, info.expected);
+      const uint64_t *bitmap = packet_buffer.GetBitmap (frame);
+      StreamingNackHeader nack;
+      for (uint32_t i = 0; i < end; i++)
+        {
+          if (!((bitmap[i / 64] >> (i % 64)) & 1))
             {
-                frame_buffer.insert({frame_index, frame_index});
-                frame_tmp.clear();
-                delete_flag = 1;
+              nack.AddMissing (i);
             }
         }
-        if (delete_flag == 1)
+      if (nack.GetMissingCount () == 0)
         {
-            packet_buffer.erase(iter++);
+          continue;
         }
-        else {
-            ++iter;
+      if (untilConsume + interval_consumer * int64_t (frame - curFrame) < repair)
+        {
+          NS_LOG_LOGIC ("Frame " << frame << " cannot be repaired in time");
+          m_nackSkippedTrace (frame, nack.GetMissingCount ());
+          // never NACK it again
+          m_nacked[frame] = Time::Max () - repair;
+          continue;
         }
+      StreamingHeader header;
+      header.SetType (StreamingHeader::NACK);
+      header.SetFrame (frame);
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (nack);
+      packet->AddHeader (header);
+      r_socket->Send (packet);
+      m_nacked[frame] = Simulator::Now ();
+      m_nackTrace (frame, nack.GetMissingCount ());
+    }
+  m_nacked.erase (m_nacked.begin (), m_nacked.lower_bound (curFrame));
+  m_nackEvent = Simulator::Schedule (m_nackInterval, &StreamingClient::SendNacks, this);
+}
+
+void
+StreamingClient::SendReport (void)
+{
+  NS_LOG_FUNCTION (this);
+  StreamingReportHeader report;
+  report.SetPaused (m_paused);
+  report.SetBufferFrames (std::min<uint32_t> (frame_buffer.size (), 65535));
+  report.SetLastFrame (m_lastFrame);
+  report.SetFramesReceived (m_framesReceived);
+  report.SetFramesLost (m_framesLost);
+  report.SetPacketsReceived (m_packetsReceived);
+  report.SetPacketsLost (m_packetsLost);
+  report.SetJitter (m_jitter);
+  StreamingHeader header;
+  header.SetType (StreamingHeader::REPORT);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (report);
+  packet->AddHeader (header);
+  r_socket->Send (packet);
+  if (m_reportInterval.IsStrictlyPositive ())
+    {
+      m_reportEvent = Simulator::Schedule (m_reportInterval, &StreamingClient::SendReport, this);
     }
-    ScheduleGenerator (interval_generator);
-    return;
 }
 
 } // Namespace ns3
@@ -25,7 +25,10 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/simulator.h"
+#include "frame-reassembly-buffer.h"
+#include "fec-codec.h"
 
 namespace ns3 {
 
@@ -51,6 +54,44 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for evicted frames.
+   *
+   * \param [in] frame The evicted frame index.
+   * \param [in] received The number of packets that had been received.
+   * \param [in] bytes The payload bytes that had been received.
+   */
+  typedef void (* FrameEvictedTracedCallback)
+    (uint32_t frame, uint32_t received, uint32_t bytes);
+
+  /**
+   * TracedCallback signature for completed frames.
+   *
+   * \param [in] frame The completed frame index.
+   * \param [in] latency Time from the first packet sent to the frame completion.
+   */
+  typedef void (* FrameCompleteTracedCallback)
+    (uint32_t frame, Time latency);
+
+  /**
+   * TracedCallback signature for frames completed by FEC.
+   *
+   * \param [in] frame The recovered frame index.
+   * \param [in] rebuilt The number of data packets rebuilt from parity.
+   */
+  typedef void (* FrameRecoveredTracedCallback)
+    (uint32_t frame, uint32_t rebuilt);
+
+  /**
+   * TracedCallback signature for NACKs.
+   *
+   * \param [in] frame The frame with missing packets.
+   * \param [in] missing The number of missing packets.
+   */
+  typedef void (* NackTracedCallback)
+    (uint32_t frame, uint32_t missing);
+
   StreamingClient ();
   virtual ~StreamingClient ();
 
@@ -78,17 +119,59 @@ private:
   Ptr<Socket> r_socket;
   Ptr<Socket> m_socket6; //!< IPv6 Socket
   Address m_local; //!< local multicast address
-  std::map <uint32_t, std::map<uint32_t,Ptr<Packet>>> packet_buffer;
+  FrameReassemblyBuffer packet_buffer; //!< per-frame packet bitmaps
+  uint32_t m_window; //!< number of frames being reassembled at once
+  uint32_t m_maxPacketsPerFrame; //!< largest number of packets in a frame
+  Ptr<FecCodec> m_codecs[FEC_REED_SOLOMON + 1]; //!< decoder of every FEC scheme
   std::map <uint32_t, uint32_t> frame_buffer;
   Time interval_consumer;
-  Time interval_generator;
   EventId m_consumeEvent;
-  EventId m_generateEvent;
   uint64_t curFrame;
   void ScheduleConsumer (Time dt);
-  void ScheduleGenerator (Time dt);
   void Consume (void);
-  void Generate (void);
+  /**
+   * \brief Move a frame whose last packet just arrived to the frame buffer.
+   * \param frame_index the completed frame
+   */
+  void Generate (uint32_t frame_index);
+  /**
+   * \brief Drop an incomplete frame from the reassembly ring.
+   * \param info the frame to drop
+   */
+  void Evict (const FrameReassemblyBuffer::FrameInfo &info);
+  /// \returns true if incomplete frames exceed the byte or frame budget
+  bool IsOverBudget (void) const;
+  /**
+   * \brief Evict the oldest incomplete frames until the deadline and the
+   * byte and frame budgets are met.
+   */
+  void EnforceBufferLimits (void);
+  /**
+   * \brief NACK the missing packets of every incomplete frame that can
+   * still be repaired before it is consumed.
+   */
+  void SendNacks (void);
+  Time m_nackInterval; //!< time between NACK rounds (0: no NACKs)
+  EventId m_nackEvent; //!< next NACK round
+  Time m_delay; //!< smoothed one-way delay of data packets
+  uint32_t m_lastFrame; //!< newest frame a packet was received for
+  std::map<uint32_t, Time> m_nacked; //!< time each frame was last NACKed
+  /**
+   * \brief Send a receiver report and schedule the next one.
+   */
+  void SendReport (void);
+  Time m_reportInterval; //!< time between receiver reports
+  EventId m_reportEvent; //!< next receiver report
+  bool m_paused; //!< frames paused, as last reported to the streamer
+  uint32_t m_framesReceived; //!< frames completed
+  uint32_t m_framesLost; //!< frames missing when due to be consumed
+  uint32_t m_packetsReceived; //!< distinct packets received
+  uint32_t m_packetsLost; //!< data packets missing from evicted or recovered frames
+  Time m_jitter; //!< interarrival jitter (RFC 3550)
+  Time m_lastTransit; //!< transit time of the previous packet
+  uint32_t m_evictionDeadline; //!< frames an incomplete frame may lag behind curFrame (0: none)
+  uint32_t m_maxBufferBytes; //!< payload byte budget of the reassembly ring (0: none)
+  uint32_t m_maxBufferFrames; //!< frame budget of the reassembly ring (0: none)
   uint32_t m_size; //!< Size of the sent packet
   Address m_peerAddress; //!< Remote peer address
   uint16_t m_peerPort; //!< Remote peer port
@@ -102,6 +185,24 @@ private:
 
   /// Callbacks for tracing the packet Rx events, includes source and destination addresses
   TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
+
+  /// Callbacks for tracing completed frames
+  TracedCallback<uint32_t, Time> m_frameCompleteTrace;
+
+  /// Callbacks for tracing frames completed by FEC
+  TracedCallback<uint32_t, uint32_t> m_frameRecoveredTrace;
+
+  /// Callbacks for tracing NACKs sent
+  TracedCallback<uint32_t, uint32_t> m_nackTrace;
+
+  /// Callbacks for tracing frames too late to be repaired
+  TracedCallback<uint32_t, uint32_t> m_nackSkippedTrace;
+
+  /// Callbacks for tracing evicted incomplete frames
+  TracedCallback<uint32_t, uint32_t, uint32_t> m_frameEvictedTrace;
+
+  /// Payload bytes held by incomplete frames
+  TracedValue<uint32_t> m_bufferBytes;
 };
 
 } // namespace ns3
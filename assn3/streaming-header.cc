@@ -0,0 +1,478 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "streaming-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("StreamingHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (StreamingHeader);
+
+StreamingHeader::StreamingHeader ()
+  : m_version (VERSION),
+    m_type (DATA),
+    m_frame (0),
+    m_index (0),
+    m_count (0),
+    m_fec (FEC_NONE),
+    m_parity (0),
+    m_ts (Simulator::Now ().GetTimeStep ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+StreamingHeader::SetType (Type type)
+{
+  m_type = type;
+}
+
+StreamingHeader::Type
+StreamingHeader::GetType (void) const
+{
+  return static_cast<Type> (m_type);
+}
+
+uint8_t
+StreamingHeader::GetVersion (void) const
+{
+  return m_version;
+}
+
+void
+StreamingHeader::SetFrame (uint32_t frame)
+{
+  m_frame = frame;
+}
+
+uint32_t
+StreamingHeader::GetFrame (void) const
+{
+  return m_frame;
+}
+
+void
+StreamingHeader::SetPacketIndex (uint16_t index)
+{
+  m_index = index;
+}
+
+uint16_t
+StreamingHeader::GetPacketIndex (void) const
+{
+  return m_index;
+}
+
+void
+StreamingHeader::SetPacketCount (uint16_t count)
+{
+  m_count = count;
+}
+
+uint16_t
+StreamingHeader::GetPacketCount (void) const
+{
+  return m_count;
+}
+
+void
+StreamingHeader::SetFec (FecScheme scheme, uint8_t parity)
+{
+  m_fec = scheme;
+  m_parity = parity;
+}
+
+FecScheme
+StreamingHeader::GetFecScheme (void) const
+{
+  return static_cast<FecScheme> (m_fec);
+}
+
+uint8_t
+StreamingHeader::GetParityCount (void) const
+{
+  return m_parity;
+}
+
+Time
+StreamingHeader::GetTs (void) const
+{
+  return TimeStep (m_ts);
+}
+
+TypeId
+StreamingHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::StreamingHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<StreamingHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+StreamingHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+StreamingHeader::Print (std::ostream &os) const
+{
+  os << "(v=" << (uint32_t) m_version << " type=" << (uint32_t) m_type
+     << " frame=" << m_frame << " index=" << m_index << "/" << m_count
+     << "+" << (uint32_t) m_parity << " fec=" << (uint32_t) m_fec
+     << " time=" << TimeStep (m_ts).GetSeconds () << ")";
+}
+
+uint32_t
+StreamingHeader::GetSerializedSize (void) const
+{
+  uint32_t size = 1 + 1 + 4 + 2 + 2 + 8;
+  if (m_version >= 2)
+    {
+      size += 1 + 1;
+    }
+  return size;
+}
+
+void
+StreamingHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (m_version);
+  i.WriteU8 (m_type);
+  i.WriteHtonU32 (m_frame);
+  i.WriteHtonU16 (m_index);
+  i.WriteHtonU16 (m_count);
+  i.WriteHtonU64 (m_ts);
+  if (m_version >= 2)
+    {
+      i.WriteU8 (m_fec);
+      i.WriteU8 (m_parity);
+    }
+}
+
+uint32_t
+StreamingHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_version = i.ReadU8 ();
+  m_type = i.ReadU8 ();
+  m_frame = i.ReadNtohU32 ();
+  m_index = i.ReadNtohU16 ();
+  m_count = i.ReadNtohU16 ();
+  m_ts = i.ReadNtohU64 ();
+  m_fec = FEC_NONE;
+  m_parity = 0;
+  if (m_version >= 2)
+    {
+      m_fec = i.ReadU8 ();
+      m_parity = i.ReadU8 ();
+    }
+  return GetSerializedSize ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (StreamingNackHeader);
+
+StreamingNackHeader::StreamingNackHeader ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+StreamingNackHeader::AddMissing (uint16_t index)
+{
+  if (!m_runs.empty ())
+    {
+      Run &last = m_runs.back ();
+      if (uint32_t (last.first) + last.length == index)
+        {
+          last.length++;
+          return;
+        }
+    }
+  Run run = { index, 1 };
+  m_runs.push_back (run);
+}
+
+std::vector<uint16_t>
+StreamingNackHeader::GetMissing (void) const
+{
+  std::vector<uint16_t> missing;
+  missing.reserve (GetMissingCount ());
+  for (std::vector<Run>::const_iterator i = m_runs.begin (); i != m_runs.end (); ++i)
+    {
+      for (uint32_t j = 0; j < i->length; j++)
+        {
+          missing.push_back (i->first + j);
+        }
+    }
+  return missing;
+}
+
+uint32_t
+StreamingNackHeader::GetMissingCount (void) const
+{
+  uint32_t count = 0;
+  for (std::vector<Run>::const_iterator i = m_runs.begin (); i != m_runs.end (); ++i)
+    {
+      count += i->length;
+    }
+  return count;
+}
+
+TypeId
+StreamingNackHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::StreamingNackHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<StreamingNackHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+StreamingNackHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+StreamingNackHeader::Print (std::ostream &os) const
+{
+  os << "(missing=";
+  for (std::vector<Run>::const_iterator i = m_runs.begin (); i != m_runs.end (); ++i)
+    {
+      os << (i == m_runs.begin () ? "" : ",") << i->first;
+      if (i->length > 1)
+        {
+          os << "-" << i->first + i->length - 1;
+        }
+    }
+  os << ")";
+}
+
+uint32_t
+StreamingNackHeader::GetSerializedSize (void) const
+{
+  return 2 + 4 * m_runs.size ();
+}
+
+void
+StreamingNackHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU16 (m_runs.size ());
+  for (std::vector<Run>::const_iterator run = m_runs.begin (); run != m_runs.end (); ++run)
+    {
+      i.WriteHtonU16 (run->first);
+      i.WriteHtonU16 (run->length);
+    }
+}
+
+uint32_t
+StreamingNackHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint16_t runs = i.ReadNtohU16 ();
+  m_runs.resize (runs);
+  for (uint16_t n = 0; n < runs; n++)
+    {
+      m_runs[n].first = i.ReadNtohU16 ();
+      m_runs[n].length = i.ReadNtohU16 ();
+    }
+  return GetSerializedSize ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (StreamingReportHeader);
+
+StreamingReportHeader::StreamingReportHeader ()
+  : m_flags (0),
+    m_bufferFrames (0),
+    m_lastFrame (0),
+    m_framesReceived (0),
+    m_framesLost (0),
+    m_packetsReceived (0),
+    m_packetsLost (0),
+    m_jitter (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+StreamingReportHeader::SetPaused (bool paused)
+{
+  m_flags = paused ? 1 : 0;
+}
+
+bool
+StreamingReportHeader::IsPaused (void) const
+{
+  return m_flags & 1;
+}
+
+void
+StreamingReportHeader::SetBufferFrames (uint16_t frames)
+{
+  m_bufferFrames = frames;
+}
+
+uint16_t
+StreamingReportHeader::GetBufferFrames (void) const
+{
+  return m_bufferFrames;
+}
+
+void
+StreamingReportHeader::SetLastFrame (uint32_t frame)
+{
+  m_lastFrame = frame;
+}
+
+uint32_t
+StreamingReportHeader::GetLastFrame (void) const
+{
+  return m_lastFrame;
+}
+
+void
+StreamingReportHeader::SetFramesReceived (uint32_t frames)
+{
+  m_framesReceived = frames;
+}
+
+uint32_t
+StreamingReportHeader::GetFramesReceived (void) const
+{
+  return m_framesReceived;
+}
+
+void
+StreamingReportHeader::SetFramesLost (uint32_t frames)
+{
+  m_framesLost = frames;
+}
+
+uint32_t
+StreamingReportHeader::GetFramesLost (void) const
+{
+  return m_framesLost;
+}
+
+void
+StreamingReportHeader::SetPacketsReceived (uint32_t packets)
+{
+  m_packetsReceived = packets;
+}
+
+uint32_t
+StreamingReportHeader::GetPacketsReceived (void) const
+{
+  return m_packetsReceived;
+}
+
+void
+StreamingReportHeader::SetPacketsLost (uint32_t packets)
+{
+  m_packetsLost = packets;
+}
+
+uint32_t
+StreamingReportHeader::GetPacketsLost (void) const
+{
+  return m_packetsLost;
+}
+
+void
+StreamingReportHeader::SetJitter (Time jitter)
+{
+  m_jitter = jitter.GetMicroSeconds ();
+}
+
+Time
+StreamingReportHeader::GetJitter (void) const
+{
+  return MicroSeconds (m_jitter);
+}
+
+TypeId
+StreamingReportHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::StreamingReportHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<StreamingReportHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+StreamingReportHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+StreamingReportHeader::Print (std::ostream &os) const
+{
+  os << "(paused=" << IsPaused () << " buffer=" << m_bufferFrames
+     << " last=" << m_lastFrame << " frames=" << m_framesReceived
+     << "/-" << m_framesLost << " packets=" << m_packetsReceived
+     << "/-" << m_packetsLost << " jitter=" << m_jitter << "us)";
+}
+
+uint32_t
+StreamingReportHeader::GetSerializedSize (void) const
+{
+  return 1 + 2 + 4 * 6;
+}
+
+void
+StreamingReportHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (m_flags);
+  i.WriteHtonU16 (m_bufferFrames);
+  i.WriteHtonU32 (m_lastFrame);
+  i.WriteHtonU32 (m_framesReceived);
+  i.WriteHtonU32 (m_framesLost);
+  i.WriteHtonU32 (m_packetsReceived);
+  i.WriteHtonU32 (m_packetsLost);
+  i.WriteHtonU32 (m_jitter);
+}
+
+uint32_t
+StreamingReportHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_flags = i.ReadU8 ();
+  m_bufferFrames = i.ReadNtohU16 ();
+  m_lastFrame = i.ReadNtohU32 ();
+  m_framesReceived = i.ReadNtohU32 ();
+  m_framesLost = i.ReadNtohU32 ();
+  m_packetsReceived = i.ReadNtohU32 ();
+  m_packetsLost = i.ReadNtohU32 ();
+  m_jitter = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
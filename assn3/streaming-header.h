@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef STREAMING_HEADER_H
+#define STREAMING_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include <vector>
+#include "fec-codec.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Header carried by every packet between StreamingStreamer and
+ *        StreamingClient
+ *
+ * Data packets identify the frame they belong to, their index inside the
+ * frame and how many packets the frame has, so frames need not all be the
+ * same size.  Control packets use the same header with another type.
+ *
+ * The first byte is a protocol version; receivers drop packets whose
+ * version they do not understand.  Version 2 added the FEC scheme and
+ * parity packet count; version 1 packets still parse, without FEC.
+ */
+class StreamingHeader : public Header
+{
+public:
+  /// Protocol version written by this implementation
+  static const uint8_t VERSION = 2;
+
+  /// Packet types
+  enum Type
+  {
+    DATA = 0,    //!< one packet of a frame
+    PAUSE = 1,   //!< client asks the streamer to stop sending frames
+    RESUME = 2,  //!< client asks the streamer to send frames again
+    PARITY = 3,  //!< one FEC parity packet of a frame
+    NACK = 4,    //!< client lists packets of a frame it is missing
+    REPORT = 5   //!< client reports its reception statistics
+  };
+
+  StreamingHeader ();
+
+  /// \param type the packet type
+  void SetType (Type type);
+  /// \returns the packet type
+  Type GetType (void) const;
+  /// \returns the protocol version of the packet
+  uint8_t GetVersion (void) const;
+  /// \param frame the frame index
+  void SetFrame (uint32_t frame);
+  /// \returns the frame index
+  uint32_t GetFrame (void) const;
+  /// \param index the packet index inside the frame
+  void SetPacketIndex (uint16_t index);
+  /// \returns the packet index inside the frame
+  uint16_t GetPacketIndex (void) const;
+  /// \param count the number of data packets in the frame
+  void SetPacketCount (uint16_t count);
+  /// \returns the number of data packets in the frame
+  uint16_t GetPacketCount (void) const;
+  /**
+   * \param scheme the FEC scheme protecting the frame
+   * \param parity the number of parity packets following the data packets
+   */
+  void SetFec (FecScheme scheme, uint8_t parity);
+  /// \returns the FEC scheme protecting the frame
+  FecScheme GetFecScheme (void) const;
+  /// \returns the number of parity packets following the data packets
+  uint8_t GetParityCount (void) const;
+  /// \returns the time the header was created
+  Time GetTs (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint8_t m_version; //!< protocol version
+  uint8_t m_type; //!< packet type
+  uint32_t m_frame; //!< frame index
+  uint16_t m_index; //!< packet index inside the frame
+  uint16_t m_count; //!< data packets in the frame
+  uint8_t m_fec; //!< FEC scheme (version 2)
+  uint8_t m_parity; //!< parity packets in the frame (version 2)
+  uint64_t m_ts; //!< creation timestamp
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Body of a NACK packet, following a StreamingHeader of type NACK
+ *
+ * The missing packet indices of the frame named in the StreamingHeader
+ * are sent as runs of consecutive indices, so a burst loss costs four
+ * bytes however long it is.
+ */
+class StreamingNackHeader : public Header
+{
+public:
+  StreamingNackHeader ();
+
+  /**
+   * \brief Add a missing packet; indices must be added in increasing order.
+   * \param index the missing packet index
+   */
+  void AddMissing (uint16_t index);
+  /// \returns the missing packet indices, in increasing order
+  std::vector<uint16_t> GetMissing (void) const;
+  /// \returns the number of missing packets
+  uint32_t GetMissingCount (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  /// A run of consecutive missing packets
+  struct Run
+  {
+    uint16_t first; //!< first missing index
+    uint16_t length; //!< number of missing indices
+  };
+  std::vector<Run> m_runs; //!< missing packets
+};
+
+/**
+ * \ingroup udpecho
+ * \brief Body of a receiver report, following a StreamingHeader of type
+ *        REPORT
+ *
+ * Counters are cumulative since the client started, so a lost report
+ * costs nothing but latency.  The report also carries whether the client
+ * wants frames paused, replacing the PAUSE and RESUME packets.
+ */
+class StreamingReportHeader : public Header
+{
+public:
+  StreamingReportHeader ();
+
+  /// \param paused true if the client asks the streamer to stop sending frames
+  void SetPaused (bool paused);
+  /// \returns true if the client asks the streamer to stop sending frames
+  bool IsPaused (void) const;
+  /// \param frames complete frames waiting to be consumed
+  void SetBufferFrames (uint16_t frames);
+  /// \returns complete frames waiting to be consumed
+  uint16_t GetBufferFrames (void) const;
+  /// \param frame newest frame a packet was received for
+  void SetLastFrame (uint32_t frame);
+  /// \returns newest frame a packet was received for
+  uint32_t GetLastFrame (void) const;
+  /// \param frames frames completed
+  void SetFramesReceived (uint32_t frames);
+  /// \returns frames completed
+  uint32_t GetFramesReceived (void) const;
+  /// \param frames frames missing when they were due to be consumed
+  void SetFramesLost (uint32_t frames);
+  /// \returns frames missing when they were due to be consumed
+  uint32_t GetFramesLost (void) const;
+  /// \param packets distinct packets received
+  void SetPacketsReceived (uint32_t packets);
+  /// \returns distinct packets received
+  uint32_t GetPacketsReceived (void) const;
+  /// \param packets data packets missing from evicted or FEC-recovered frames
+  void SetPacketsLost (uint32_t packets);
+  /// \returns data packets missing from evicted or FEC-recovered frames
+  uint32_t GetPacketsLost (void) const;
+  /// \param jitter interarrival jitter (RFC 3550)
+  void SetJitter (Time jitter);
+  /// \returns interarrival jitter, with microsecond resolution
+  Time GetJitter (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint8_t m_flags; //!< bit 0: paused
+  uint16_t m_bufferFrames; //!< complete frames waiting to be consumed
+  uint32_t m_lastFrame; //!< newest frame seen
+  uint32_t m_framesReceived; //!< frames completed
+  uint32_t m_framesLost; //!< frames missing at consume time
+  uint32_t m_packetsReceived; //!< distinct packets received
+  uint32_t m_packetsLost; //!< data packets missing
+  uint32_t m_jitter; //!< interarrival jitter in microseconds
+};
+
+} // namespace ns3
+
+#endif /* STREAMING_HEADER_H */
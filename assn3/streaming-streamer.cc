@@ -26,14 +26,22 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
-#include "ns3/seq-ts-header.h"
+#include "streaming-header.h"
 #include "streaming-streamer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("StreamingStreamerApplication");
 
+/// Data packets of a frame, leaving room for parity in the 16-bit packet index
+static const uint32_t g_maxFramePackets = 65280;
+
 NS_OBJECT_ENSURE_REGISTERED (StreamingStreamer);
 
 TypeId
@@ -44,7 +52,8 @@ StreamingStreamer::GetTypeId (void)
     .SetGroupName("Applications")
     .AddConstructor<StreamingStreamer> ()
     .AddAttribute ("MaxPackets", 
-                   "The maximum number of packets the application will send",
+                   "The maximum number of packets sent to each session; once "
+                   "every session has had them, no further frames are queued",
                    UintegerValue (100),
                    MakeUintegerAccessor (&StreamingStreamer::m_count),
                    MakeUintegerChecker<uint32_t> ())
@@ -80,11 +89,70 @@ StreamingStreamer::GetTypeId (void)
     .AddTraceSource ("RxWithAddresses", "A packet has been received",
                      MakeTraceSourceAccessor (&StreamingStreamer::m_rxTraceWithAddresses),
                      "ns3::Packet::TwoAddressTracedCallback")
+    .AddTraceSource ("Report", "A receiver report has been received",
+                     MakeTraceSourceAccessor (&StreamingStreamer::m_reportTrace),
+                     "ns3::StreamingStreamer::ReportTracedCallback")
     .AddAttribute ("ReceivePort", 
                    "The destination port of the outbound packets",
                    UintegerValue (0),
                    MakeUintegerAccessor (&StreamingStreamer::m_recvPort),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("TraceFile",
+                   "Frame size trace to packetize (one size in bytes per line, "
+                   "or the binary FST1 format); empty for fixed-size frames",
+                   StringValue (""),
+                   MakeStringAccessor (&StreamingStreamer::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("PacketsPerFrame",
+                   "Number of packets making up one frame when no TraceFile is set",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&StreamingStreamer::m_packetsPerFrame),
+                   MakeUintegerChecker<uint32_t> (1, g_maxFramePackets))
+    .AddAttribute ("SendCacheFrames",
+                   "Number of recent frames whose packets can be retransmitted on NACK",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&StreamingStreamer::m_cacheFrames),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacingMode",
+                   "How the packets of a frame are spread over the frame interval",
+                   EnumValue (StreamingStreamer::BURST),
+                   MakeEnumAccessor (&StreamingStreamer::m_pacing),
+                   MakeEnumChecker (StreamingStreamer::BURST, "Burst",
+                                    StreamingStreamer::PACED, "Paced",
+                                    StreamingStreamer::TOKEN_BUCKET, "TokenBucket"))
+    .AddAttribute ("FecScheme",
+                   "Forward error correction code protecting every frame",
+                   EnumValue (FEC_NONE),
+                   MakeEnumAccessor (&StreamingStreamer::m_fecScheme),
+                   MakeEnumChecker (FEC_NONE, "None",
+                                    FEC_XOR, "Xor",
+                                    FEC_REED_SOLOMON, "ReedSolomon"))
+    .AddAttribute ("FecParityPackets",
+                   "Parity packets added to every frame when FecScheme is set",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&StreamingStreamer::m_fecParity),
+                   MakeUintegerChecker<uint32_t> (1, 255))
+    .AddAttribute ("MaxSessions",
+                   "Largest number of clients served at the same time",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&StreamingStreamer::m_maxSessions),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Scheduler",
+                   "How the sessions share the sender",
+                   EnumValue (StreamingStreamer::ROUND_ROBIN),
+                   MakeEnumAccessor (&StreamingStreamer::m_scheduler),
+                   MakeEnumChecker (StreamingStreamer::ROUND_ROBIN, "RoundRobin",
+                                    StreamingStreamer::WEIGHTED, "Weighted"))
+    .AddAttribute ("PacingRate",
+                   "Token bucket fill rate of every session (TokenBucket pacing only)",
+                   DataRateValue (DataRate ("100Mb/s")),
+                   MakeDataRateAccessor (&StreamingStreamer::m_pacingRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("BucketSize",
+                   "Token bucket depth in bytes (TokenBucket pacing only)",
+                   UintegerValue (16384),
+                   MakeUintegerAccessor (&StreamingStreamer::m_bucketSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -95,7 +163,10 @@ StreamingStreamer::StreamingStreamer ()
   m_sent = 0;
   m_resent = 0;
   m_socket = 0;
+  m_socket6 = 0;
   m_sendEvent = EventId ();
+  m_pacingEvent = EventId ();
+  m_nextSession = 0;
   m_data = 0;
   m_dataSize = 0;
   seqNumber = 0;
@@ -103,7 +174,6 @@ StreamingStreamer::StreamingStreamer ()
   lossNumber = 0;
   reNumber = 0;
   lastEchoNumber = 0;
-  send_state = 1;
   r_socket = 0;
 }
 
@@ -113,6 +183,7 @@ StreamingStreamer::~StreamingStreamer()
   //NS_LOG_INFO("Q1)Packet Drop Ratio:" << (float(lossNumber + seqNumber - lastEchoNumber)*100. / float(seqNumber)) << "%");
   //NS_LOG_INFO("Q2)Packet Retransmit Success Ratio:" << (float(reNumber) * 100. / float(lossNumber)) << "%");
   m_socket = 0;
+  m_socket6 = 0;
 
   delete [] m_data;
   m_data = 0;
@@ -134,10 +205,22 @@ StreamingStreamer::SetRemote (Address addr)
   m_peerAddress = addr;
 }
 
+void
+StreamingStreamer::AddSession (Address ip, uint32_t weight)
+{
+  NS_LOG_FUNCTION (this << ip << weight);
+  m_initialSessions.push_back (std::make_pair (ip, weight));
+}
+
 void
 StreamingStreamer::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_payload = 0;
+  m_parityPayloads.clear ();
+  m_parityFill = 0;
+  m_sessions.clear ();
+  m_batch.clear ();
   Application::DoDispose ();
 }
 
@@ -146,6 +229,14 @@ StreamingStreamer::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
+  uint64_t maxFrameSize = std::min<uint64_t> (uint64_t (g_maxFramePackets) * m_size, UINT32_MAX);
+  if (!m_traceFile.empty () && !m_trace.Open (m_traceFile, static_cast<uint32_t> (maxFrameSize)))
+    {
+      NS_FATAL_ERROR ("Failed to read frame size trace " << m_traceFile);
+    }
+  m_codec = MakeFecCodec (m_fecScheme);
+  m_parityFrame.count = 0;
+
   if (r_socket == 0)
     {
       TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
@@ -157,52 +248,23 @@ StreamingStreamer::StartApplication (void)
           NS_FATAL_ERROR ("Failed to bind socket");
         }
     }
-  if (m_socket == 0)
+  r_socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
+
+  m_sessions.clear ();
+  m_sessionIndex.clear ();
+  m_batch.clear ();
+  m_batchSessions.clear ();
+  m_nextSession = 0;
+  // first, so that a weight given to RemoteAddress by AddSession holds
+  for (uint32_t i = 0; i < m_initialSessions.size (); i++)
+    {
+      FindSession (GetPeer (m_initialSessions[i].first), m_initialSessions[i].second);
+    }
+  if (!m_peerAddress.IsInvalid ())
     {
-      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-      m_socket = Socket::CreateSocket (GetNode (), tid);
       NS_LOG_INFO(m_peerAddress);
-      if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
-        {
-          if (m_socket->Bind () == -1)
-            {
-              NS_FATAL_ERROR ("Failed to bind socket");
-            }
-          m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
-        }
-      else if (Ipv6Address::IsMatchingType(m_peerAddress) == true)
-        {
-          if (m_socket->Bind6 () == -1)
-            {
-              NS_FATAL_ERROR ("Failed to bind socket");
-            }
-          m_socket->Connect (Inet6SocketAddress (Ipv6Address::ConvertFrom(m_peerAddress), m_peerPort));
-        }
-      else if (InetSocketAddress::IsMatchingType (m_peerAddress) == true)
-        {
-          if (m_socket->Bind () == -1)
-            {
-              NS_FATAL_ERROR ("Failed to bind socket");
-            }
-          m_socket->Connect (m_peerAddress);
-        }
-      else if (Inet6SocketAddress::IsMatchingType (m_peerAddress) == true)
-        {
-          if (m_socket->Bind6 () == -1)
-            {
-              NS_FATAL_ERROR ("Failed to bind socket");
-            }
-          m_socket->Connect (m_peerAddress);
-        }
-      else
-        {
-          NS_ASSERT_MSG (false, "Incompatible address type: " << m_peerAddress);
-        }
+      FindSession (GetPeer (m_peerAddress), 1);
     }
-
-  r_socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleReadr, this));
-  m_socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
-  m_socket->SetAllowBroadcast (true);
   ScheduleTransmit (Seconds (0.));
 }
 
@@ -217,8 +279,90 @@ StreamingStreamer::StopApplication ()
       m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
       m_socket = 0;
     }
+  if (m_socket6 != 0) 
+    {
+      m_socket6->Close ();
+      m_socket6->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket6 = 0;
+    }
 
   Simulator::Cancel (m_sendEvent);
+  Simulator::Cancel (m_pacingEvent);
+}
+
+Address
+StreamingStreamer::GetPeer (const Address &address) const
+{
+  if (Ipv4Address::IsMatchingType (address))
+    {
+      return InetSocketAddress (Ipv4Address::ConvertFrom (address), m_peerPort);
+    }
+  else if (Ipv6Address::IsMatchingType (address))
+    {
+      return Inet6SocketAddress (Ipv6Address::ConvertFrom (address), m_peerPort);
+    }
+  else if (InetSocketAddress::IsMatchingType (address))
+    {
+      return InetSocketAddress (InetSocketAddress::ConvertFrom (address).GetIpv4 (), m_peerPort);
+    }
+  else if (Inet6SocketAddress::IsMatchingType (address))
+    {
+      return Inet6SocketAddress (Inet6SocketAddress::ConvertFrom (address).GetIpv6 (), m_peerPort);
+    }
+  NS_ASSERT_MSG (false, "Incompatible address type: " << address);
+  return Address ();
+}
+
+StreamingStreamer::Session *
+StreamingStreamer::FindSession (const Address &peer, uint32_t weight)
+{
+  std::map<Address, uint32_t>::iterator it = m_sessionIndex.find (peer);
+  if (it != m_sessionIndex.end ())
+    {
+      return &m_sessions[it->second];
+    }
+  if (m_sessions.size () >= m_maxSessions)
+    {
+      NS_LOG_WARN ("Session table full, ignoring " << peer);
+      return 0;
+    }
+  NS_LOG_INFO ("New session " << m_sessions.size () << " for " << peer);
+  PendingFrame empty = PendingFrame ();
+  Session session;
+  session.peer = peer;
+  session.weight = std::max<uint32_t> (weight, 1);
+  session.paused = false;
+  session.frameNumber = 0;
+  session.sent = 0;
+  session.cache.assign (m_cacheFrames, empty);
+  session.tokens = m_bucketSize;
+  session.lastRefill = Simulator::Now ();
+  session.nextSend = Simulator::Now ();
+  // resolved once, not per packet
+  session.socket = GetSocket (peer);
+  session.socket->GetSockName (session.local);
+  m_sessionIndex[peer] = m_sessions.size ();
+  m_sessions.push_back (session);
+  return &m_sessions.back ();
+}
+
+Ptr<Socket>
+StreamingStreamer::GetSocket (const Address &peer)
+{
+  bool v6 = Inet6SocketAddress::IsMatchingType (peer);
+  Ptr<Socket> &socket = v6 ? m_socket6 : m_socket;
+  if (socket == 0)
+    {
+      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+      socket = Socket::CreateSocket (GetNode (), tid);
+      if ((v6 ? socket->Bind6 () : socket->Bind ()) == -1)
+        {
+          NS_FATAL_ERROR ("Failed to bind socket");
+        }
+      socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
+      socket->SetAllowBroadcast (true);
+    }
+  return socket;
 }
 
 void 
@@ -235,6 +379,7 @@ StreamingStreamer::SetDataSize (uint32_t dataSize)
   m_data = 0;
   m_dataSize = 0;
   m_size = dataSize;
+  m_payload = Create<Packet> (dataSize);
 }
 
 uint32_t 
@@ -264,6 +409,7 @@ StreamingStreamer::SetFill (std::string fill)
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -283,6 +429,7 @@ StreamingStreamer::SetFill (uint8_t fill, uint32_t dataSize)
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -300,6 +447,7 @@ StreamingStreamer::SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataSize)
     {
       memcpy (m_data, fill, dataSize);
       m_size = dataSize;
+      m_payload = Create<Packet> (m_data, dataSize);
       return;
     }
 
@@ -322,6 +470,7 @@ StreamingStreamer::SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataSize)
   // Overwrite packet size attribute.
   //
   m_size = dataSize;
+  m_payload = Create<Packet> (m_data, dataSize);
 }
 
 void 
@@ -337,138 +486,297 @@ StreamingStreamer::Send (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_sendEvent.IsExpired ());
-  if (send_state == 0) {
-    if (m_sent < m_count)
+
+  PendingFrame frame;
+  frame.next = 0;
+  if (m_trace.IsOpen ())
     {
-      ScheduleTransmit (m_interval);
+      uint32_t bytes = std::max<uint32_t> (m_trace.Next (), 1);
+      uint32_t count = std::min<uint32_t> ((bytes + m_size - 1) / m_size, g_maxFramePackets);
+      frame.count = count;
+      frame.lastSize = std::min (bytes - (count - 1) * m_size, m_size);
     }
-    return;
-  }
-
-  for (int i=0; i<100; i++)
-  {
-      Ptr<Packet> p;
+  else
+    {
+      frame.count = m_packetsPerFrame;
+      frame.lastSize = m_size;
+    }
+  frame.parity = 0;
+  if (m_codec != 0 && m_codec->Supports (frame.count, m_fecParity))
+    {
+      frame.parity = m_fecParity;
       if (m_dataSize)
         {
-          //
-          // If m_dataSize is non-zero, we have a data buffer of the same size that we
-          // are expected to copy and send.  This state of affairs is created if one of
-          // the Fill functions is called.  In this case, m_size must have been set
-          // to agree with m_dataSize
-          //
-          NS_ASSERT_MSG (m_dataSize == m_size, "StreamingStreamer::Send(): m_size and m_dataSize inconsistent");
-          NS_ASSERT_MSG (m_data, "StreamingStreamer::Send(): m_dataSize but no m_data");
-          p = Create<Packet> (m_data, m_dataSize);
+          EncodeParity (frame);
         }
-      else
+    }
+  // every session streams the same frame under its own numbering
+  for (uint32_t i = 0; i < m_sessions.size (); i++)
+    {
+      Session &session = m_sessions[i];
+      if (session.paused || session.sent >= m_count)
         {
-          //
-          // If m_dataSize is zero, the client has indicated that it doesn't care
-          // about the data itself either by specifying the data size by setting
-          // the corresponding attribute or by not calling a SetFill function.  In
-          // this case, we don't worry about it either.  But we do allow m_size
-          // to have a value different from the (zero) m_dataSize.
-          //
-          p = Create<Packet> (m_size);
+          continue;
         }
-      Address localAddress;
-      m_socket->GetSockName (localAddress);
-      // call to the trace sinks before the packet is actually sent,
-      // so that tags added to the packet can be sent as well
-      m_txTrace (p);
-      if (Ipv4Address::IsMatchingType (m_peerAddress))
+      frame.frame = session.frameNumber++;
+      session.cache[frame.frame % session.cache.size ()] = frame;
+      session.pending.push_back (frame);
+    }
+  Simulator::Cancel (m_pacingEvent);
+  SendPending ();
+
+  // keep going until every session has had MaxPackets, or none joined yet
+  bool more = m_sessions.empty ();
+  for (uint32_t i = 0; i < m_sessions.size () && !more; i++)
+    {
+      more = m_sessions[i].sent < m_count;
+    }
+  if (more)
+    {
+      ScheduleTransmit (m_interval);
+    }
+}
+
+void
+StreamingStreamer::SendPending (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t sessions = m_sessions.size ();
+  bool progress = true;
+  while (progress)
+    {
+      progress = false;
+      for (uint32_t visited = 0; visited < sessions; visited++)
         {
-          m_txTraceWithAddresses (p, localAddress, InetSocketAddress (Ipv4Address::ConvertFrom (m_peerAddress), m_peerPort));
+          uint32_t id = m_nextSession;
+          Session &session = m_sessions[id];
+          m_nextSession = (m_nextSession + 1) % sessions;
+          uint32_t quantum = m_scheduler == WEIGHTED ? session.weight : 1;
+          for (uint32_t i = 0; i < quantum && !session.pending.empty () && CanSend (session); i++)
+            {
+              QueuePacket (id);
+              progress = true;
+            }
         }
-      else if (Ipv6Address::IsMatchingType (m_peerAddress))
+    }
+  SendBatch ();
+
+  // whatever is left waits for its pacing
+  Time wake = Time::Max ();
+  for (uint32_t i = 0; i < sessions; i++)
+    {
+      if (!m_sessions[i].pending.empty ())
         {
-          m_txTraceWithAddresses (p, localAddress, Inet6SocketAddress (Ipv6Address::ConvertFrom (m_peerAddress), m_peerPort));
+          wake = std::min (wake, m_sessions[i].nextSend);
         }
-      //NS_LOG_INFO(std::to_string(seqNumber));
-      SeqTsHeader seqTs;
-      seqTs.SetSeq(seqNumber++);
-      p->AddHeader(seqTs);
-      m_socket->Send (p);
-      ++m_sent;
-  }
+    }
+  if (wake != Time::Max ())
+    {
+      m_pacingEvent = Simulator::Schedule (wake - Simulator::Now (),
+                                           &StreamingStreamer::SendPending, this);
+    }
+}
 
-  if (m_sent < m_count)
+bool
+StreamingStreamer::CanSend (Session &session)
+{
+  Time now = Simulator::Now ();
+  if (m_pacing == TOKEN_BUCKET)
     {
-      ScheduleTransmit (m_interval);
+      uint32_t size = GetNextPacketSize (session);
+      RefillTokens (session);
+      if (session.tokens < size)
+        {
+          session.nextSend = now + m_pacingRate.CalculateBytesTxTime (std::ceil (size - session.tokens));
+          return false;
+        }
+      session.tokens -= size;
+      return true;
+    }
+  if (m_pacing == PACED && now < session.nextSend)
+    {
+      return false;
     }
+  if (m_pacing == PACED)
+    {
+      const PendingFrame &frame = session.pending.front ();
+      session.nextSend = now + m_interval / (frame.count + frame.parity);
+    }
+  return true;
 }
 
-void 
-StreamingStreamer::ReTransmit (uint32_t pktNum)
+void
+StreamingStreamer::RefillTokens (Session &session)
 {
-  NS_LOG_FUNCTION (this);
+  // a bucket smaller than one packet would never let anything through
+  double depth = std::max (m_bucketSize, m_size);
+  Time now = Simulator::Now ();
+  session.tokens += m_pacingRate.GetBitRate () * (now - session.lastRefill).GetSeconds () / 8;
+  session.tokens = std::min (session.tokens, depth);
+  session.lastRefill = now;
+}
+
+uint32_t
+StreamingStreamer::GetNextPacketSize (const Session &session) const
+{
+  const PendingFrame &frame = session.pending.front ();
+  return frame.next + 1 == frame.count ? frame.lastSize : m_size;
+}
 
+void
+StreamingStreamer::EncodeParity (PendingFrame &frame)
+{
+  NS_LOG_FUNCTION (this << frame.count << frame.lastSize);
+  if (frame.count == m_parityFrame.count && frame.parity == m_parityFrame.parity
+      && frame.lastSize == m_parityFrame.lastSize && m_payload == m_parityFill)
+    {
+      // same fill data, same shape: the parity of the last frame still holds
+      frame.parityPayloads = m_parityPayloads;
+      return;
+    }
+  m_parityFrame = frame;
+  m_parityFill = m_payload;
+  // every data packet carries the fill data; the last one is shorter and
+  // is zero-padded to the block size
+  std::vector<uint8_t> last (m_size, 0);
+  std::memcpy (&last[0], m_data, frame.lastSize);
+  m_parityData.assign (frame.parity * m_size, 0);
+  std::vector<uint8_t *> blocks (frame.count + frame.parity, m_data);
+  blocks[frame.count - 1] = &last[0];
+  for (uint32_t j = 0; j < frame.parity; j++)
+    {
+      blocks[frame.count + j] = &m_parityData[j * m_size];
+    }
+  m_codec->Encode (blocks, frame.count, frame.parity, m_size);
+  // frames still queued keep the templates they were given
+  m_parityPayloads.clear ();
+  for (uint32_t j = 0; j < frame.parity; j++)
+    {
+      m_parityPayloads.push_back (Create<Packet> (&m_parityData[j * m_size], m_size));
+    }
+  frame.parityPayloads = m_parityPayloads;
+}
+
+void
+StreamingStreamer::QueuePacket (uint32_t id)
+{
+  Session &session = m_sessions[id];
+  NS_LOG_FUNCTION (this << session.peer);
+  PendingFrame &frame = session.pending.front ();
+  uint32_t size = GetNextPacketSize (session);
   Ptr<Packet> p;
   if (m_dataSize)
     {
+      //
+      // If m_dataSize is non-zero, we have a data buffer of the same size that we
+      // are expected to copy and send.  This state of affairs is created if one of
+      // the Fill functions is called.  In this case, m_size must have been set
+      // to agree with m_dataSize
+      //
       NS_ASSERT_MSG (m_dataSize == m_size, "StreamingStreamer::Send(): m_size and m_dataSize inconsistent");
       NS_ASSERT_MSG (m_data, "StreamingStreamer::Send(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
+      // copies of the templates share their data until written to
+      if (frame.next < frame.count)
+        {
+          p = m_payload->CreateFragment (0, size);
+        }
+      else
+        {
+          p = frame.parityPayloads[frame.next - frame.count]->Copy ();
+        }
     }
   else
     {
-      p = Create<Packet> (m_size);
+      //
+      // If m_dataSize is zero, the client has indicated that it doesn't care
+      // about the data itself either by specifying the data size by setting
+      // the corresponding attribute or by not calling a SetFill function.  In
+      // this case, we don't worry about it either.  But we do allow m_size
+      // to have a value different from the (zero) m_dataSize.
+      //
+      p = m_payload->CreateFragment (0, size);
     }
-  Address localAddress;
-  m_socket->GetSockName (localAddress);
   // call to the trace sinks before the packet is actually sent,
   // so that tags added to the packet can be sent as well
-  m_txTrace (p);
-  if (Ipv4Address::IsMatchingType (m_peerAddress))
+  if (!m_txTrace.IsEmpty ())
     {
-      m_txTraceWithAddresses (p, localAddress, InetSocketAddress (Ipv4Address::ConvertFrom (m_peerAddress), m_peerPort));
+      m_txTrace (p);
     }
-  else if (Ipv6Address::IsMatchingType (m_peerAddress))
+  if (!m_txTraceWithAddresses.IsEmpty ())
     {
-      m_txTraceWithAddresses (p, localAddress, Inet6SocketAddress (Ipv6Address::ConvertFrom (m_peerAddress), m_peerPort));
+      m_txTraceWithAddresses (p, session.local, session.peer);
+    }
+  StreamingHeader header;
+  if (frame.next >= frame.count)
+    {
+      header.SetType (StreamingHeader::PARITY);
+    }
+  header.SetFrame (frame.frame);
+  header.SetPacketIndex (frame.next++);
+  header.SetPacketCount (frame.count);
+  header.SetFec (frame.parity ? m_fecScheme : FEC_NONE, frame.parity);
+  p->AddHeader(header);
+  m_batch.push_back (p);
+  m_batchSessions.push_back (id);
+  if (frame.next == uint32_t (frame.count) + frame.parity)
+    {
+      session.pending.pop_front ();
     }
-  SeqTsHeader seqTs;
-  seqTs.SetSeq(pktNum);
-  p->AddHeader(seqTs);
-  m_socket->Send (p);
-  ++m_resent;
-  //NS_LOG_INFO("Packet Retrans:" << pktNum);
 }
+
 void
-StreamingStreamer::HandleRead (Ptr<Socket> socket)
+StreamingStreamer::SendBatch (void)
 {
-  NS_LOG_FUNCTION (this << socket);
-  Ptr<Packet> packet;
-  Address from;
-  Address localAddress;
-  while ((packet = socket->RecvFrom (from)))
+  NS_LOG_FUNCTION (this << m_batch.size ());
+  for (uint32_t i = 0; i < m_batch.size (); i++)
     {
-        socket->GetSockName (localAddress);
-        SeqTsHeader seqTs;
-        packet->RemoveHeader(seqTs);
-        uint32_t seqNumber = seqTs.GetSeq();
-        const uint32_t pause_type = -1;
-        const uint32_t resume_type = -2;
-        // todo
-        /*
-         * packet_type
-         * 1 : pause
-         * 2 : resume
-         * etc : general echo packet
-         *
-         */
-        switch(seqNumber) {
-            case pause_type:
-                send_state = 0;
-                break;
-            case resume_type:
-                send_state = 1;
-                break;
-        }
+      Session &session = m_sessions[m_batchSessions[i]];
+      session.socket->SendTo (m_batch[i], 0, session.peer);
+      session.sent++;
+    }
+  m_sent += m_batch.size ();
+  // keep the capacity for the next pass
+  m_batch.clear ();
+  m_batchSessions.clear ();
+}
+
+void 
+StreamingStreamer::ReTransmit (Session &session, uint32_t frame, uint16_t index)
+{
+  NS_LOG_FUNCTION (this << session.peer << frame << index);
+
+  const PendingFrame &cached = session.cache[frame % session.cache.size ()];
+  if (cached.count == 0 || cached.frame != frame || index >= cached.count)
+    {
+      NS_LOG_LOGIC ("Packet " << index << " of frame " << frame << " not in the send cache");
+      return;
     }
+  uint32_t size = index + 1 == cached.count ? cached.lastSize : m_size;
+  NS_ASSERT_MSG (m_dataSize == 0 || m_dataSize == m_size, "StreamingStreamer::Send(): m_size and m_dataSize inconsistent");
+  Ptr<Packet> p = m_payload->CreateFragment (0, size);
+  // call to the trace sinks before the packet is actually sent,
+  // so that tags added to the packet can be sent as well
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (p);
+    }
+  if (!m_txTraceWithAddresses.IsEmpty ())
+    {
+      m_txTraceWithAddresses (p, session.local, session.peer);
+    }
+  StreamingHeader header;
+  header.SetFrame (frame);
+  header.SetPacketIndex (index);
+  header.SetPacketCount (cached.count);
+  header.SetFec (cached.parity ? m_fecScheme : FEC_NONE, cached.parity);
+  p->AddHeader(header);
+  session.socket->SendTo (p, 0, session.peer);
+  ++m_resent;
+  //NS_LOG_INFO("Packet Retrans:" << pktNum);
 }
+
 void
-StreamingStreamer::HandleReadr (Ptr<Socket> socket)
+StreamingStreamer::HandleRead (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
   Ptr<Packet> packet;
@@ -477,25 +785,45 @@ StreamingStreamer::HandleReadr (Ptr<Socket> socket)
   while ((packet = socket->RecvFrom (from)))
     {
         socket->GetSockName (localAddress);
-        SeqTsHeader seqTs;
-        packet->RemoveHeader(seqTs);
-        uint32_t seqNumber = seqTs.GetSeq();
-        const uint32_t pause_type = -1;
-        const uint32_t resume_type = -2;
-        // todo
-        /*
-         * packet_type
-         * 1 : pause
-         * 2 : resume
-         * etc : general echo packet
-         *
-         */
-        switch(seqNumber) {
-            case pause_type:
-                send_state = 0;
+        m_rxTrace (packet);
+        m_rxTraceWithAddresses (packet, from, localAddress);
+        StreamingHeader header;
+        packet->RemoveHeader(header);
+        if (header.GetVersion () > StreamingHeader::VERSION)
+          {
+            NS_LOG_LOGIC ("Ignoring packet " << header);
+            continue;
+          }
+        // a control packet from an unknown client opens its session
+        Session *session = FindSession (GetPeer (from), 1);
+        if (session == 0)
+          {
+            continue;
+          }
+        switch(header.GetType ()) {
+            case StreamingHeader::PAUSE:
+                session->paused = true;
+                break;
+            case StreamingHeader::RESUME:
+                session->paused = false;
+                break;
+            case StreamingHeader::REPORT:
+                packet->RemoveHeader (session->report);
+                session->paused = session->report.IsPaused ();
+                m_reportTrace (session->peer, session->report);
+                break;
+            case StreamingHeader::NACK:
+              {
+                StreamingNackHeader nack;
+                packet->RemoveHeader (nack);
+                std::vector<uint16_t> missing = nack.GetMissing ();
+                for (uint32_t i = 0; i < missing.size (); i++)
+                  {
+                    ReTransmit (*session, header.GetFrame (), missing[i]);
+                  }
                 break;
-            case resume_type:
-                send_state = 1;
+              }
+            default:
                 break;
         }
     }
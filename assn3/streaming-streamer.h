@@ -24,6 +24,13 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/data-rate.h"
+#include <deque>
+#include <map>
+#include <vector>
+#include "frame-size-trace.h"
+#include "fec-codec.h"
+#include "streaming-header.h"
 
 namespace ns3 {
 
@@ -35,6 +42,15 @@ class Packet;
  * \brief A Udp Echo client
  *
  * Every packet sent should be returned by the server and received here.
+ *
+ * One streamer serves any number of clients.  Each client has a session
+ * with its own pause state, frame numbering, send cache and pacing; the
+ * sessions share one socket and are served round robin.
+ *
+ * The packets a scheduling pass releases are built first and then handed
+ * to the sockets together; each session keeps its socket and local
+ * address from when it was opened, and Tx traces are only built when a
+ * sink is connected.
  */
 class StreamingStreamer : public Application 
 {
@@ -45,6 +61,30 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /// How the packets of a frame are spread over the frame interval
+  enum PacingMode
+  {
+    BURST,        //!< all packets of a frame back to back
+    PACED,        //!< packets evenly spaced over the frame interval
+    TOKEN_BUCKET  //!< packets released by a token bucket
+  };
+
+  /// How sessions share the sender
+  enum SchedulerMode
+  {
+    ROUND_ROBIN,  //!< one packet per session in turn
+    WEIGHTED      //!< as many packets per turn as the session weight
+  };
+
+  /**
+   * TracedCallback signature for receiver reports.
+   *
+   * \param [in] client The socket address frames are sent to.
+   * \param [in] report The report.
+   */
+  typedef void (* ReportTracedCallback)
+    (const Address &client, const StreamingReportHeader &report);
+
   StreamingStreamer ();
 
   virtual ~StreamingStreamer ();
@@ -60,6 +100,16 @@ public:
    * \param addr remote address
    */
   void SetRemote (Address addr);
+  /**
+   * \brief Stream to one more client.
+   *
+   * Clients also join by sending a control packet to ReceivePort.
+   *
+   * \param ip client IP address
+   * \param weight packets the session sends per scheduling round, with
+   *        the Weighted scheduler
+   */
+  void AddSession (Address ip, uint32_t weight = 1);
 
   /**
    * Set the data size of the packet (the number of bytes that are sent as data
@@ -134,6 +184,34 @@ protected:
   virtual void DoDispose (void);
 
 private:
+  /// A frame whose packets are being sent
+  struct PendingFrame
+  {
+    uint32_t frame; //!< frame index
+    uint16_t count; //!< data packets in the frame
+    uint8_t parity; //!< parity packets following the data packets
+    uint32_t next; //!< index of the next packet to send
+    uint32_t lastSize; //!< payload size of the last data packet
+    std::vector<Ptr<Packet> > parityPayloads; //!< parity packet templates, shared by every session
+  };
+
+  /// State of one receiving client
+  struct Session
+  {
+    Address peer; //!< socket address frames are sent to
+    uint32_t weight; //!< packets sent per scheduling round (Weighted only)
+    bool paused; //!< client asked to stop sending frames
+    uint32_t frameNumber; //!< index of the next frame
+    uint32_t sent; //!< packets sent to peer, retransmissions aside
+    std::deque<PendingFrame> pending; //!< frames queued but not yet fully sent
+    std::vector<PendingFrame> cache; //!< recent frames, indexed by frame % m_cacheFrames
+    double tokens; //!< bytes currently available in the bucket
+    Time lastRefill; //!< last time tokens were added
+    Time nextSend; //!< earliest time the pacing lets the next packet go
+    StreamingReportHeader report; //!< last receiver report
+    Ptr<Socket> socket; //!< socket sending to peer
+    Address local; //!< local address of socket
+  };
 
   virtual void StartApplication (void);
   virtual void StopApplication (void);
@@ -144,10 +222,70 @@ private:
    */
   void ScheduleTransmit (Time dt);
   /**
-   * \brief Send a packet
+   * \brief Queue the next frame of every session that is not paused
    */
   void Send (void);
-  void ReTransmit (uint32_t);
+  /**
+   * \brief Send queued packets of all sessions, round robin, as their
+   * pacing allows
+   */
+  void SendPending (void);
+  /**
+   * \brief Check the pacing of a session and take the tokens of its next packet
+   * \param session the session
+   * \returns true if the next queued packet may go now; otherwise
+   *          session.nextSend tells when it may
+   */
+  bool CanSend (Session &session);
+  /**
+   * \brief Build the next queued packet of a session and add it to the batch
+   * \param id the session index
+   */
+  void QueuePacket (uint32_t id);
+  /**
+   * \brief Send every packet of the batch, in the order queued
+   */
+  void SendBatch (void);
+  /**
+   * \brief Add the tokens earned since the last refill to a session's bucket
+   * \param session the session
+   */
+  void RefillTokens (Session &session);
+  /**
+   * \param session the session
+   * \returns the payload size of the next queued packet
+   */
+  uint32_t GetNextPacketSize (const Session &session) const;
+  /**
+   * \brief Set the parity packet templates of a frame, computed from the
+   * fill data unless the last frame of the same shape and fill has them
+   * \param frame the frame about to be queued
+   */
+  void EncodeParity (PendingFrame &frame);
+  /**
+   * \brief Send one data packet of a cached frame again
+   * \param session the session that lost the packet
+   * \param frame the frame index
+   * \param index the packet index inside the frame
+   */
+  void ReTransmit (Session &session, uint32_t frame, uint16_t index);
+  /**
+   * \param address a socket address
+   * \returns the socket address of the same host on RemotePort
+   */
+  Address GetPeer (const Address &address) const;
+  /**
+   * \param peer the socket address of a client
+   * \param weight packets the session sends per scheduling round
+   * \returns the session of the client, created if needed, or a null
+   *          pointer if the table is full
+   */
+  Session *FindSession (const Address &peer, uint32_t weight);
+  /**
+   * \param peer a socket address
+   * \returns the socket to send to the peer, created if needed
+   */
+  Ptr<Socket> GetSocket (const Address &peer);
 
   /**
    * \brief Handle a packet reception.
@@ -157,29 +295,55 @@ private:
    * \param socket the socket the packet was received to.
    */
   void HandleRead (Ptr<Socket> socket);
-  void HandleReadr (Ptr<Socket> socket);
 
-  uint32_t m_count; //!< Maximum number of packets the application will send
+  uint32_t m_count; //!< Maximum number of packets sent to each session
   Time m_interval; //!< Packet inter-send time
   uint32_t m_size; //!< Size of the sent packet
 
   uint32_t m_dataSize; //!< packet payload size (must be equal to m_size)
   uint8_t *m_data; //!< packet payload data
+  Ptr<Packet> m_payload; //!< data packet template, shared copy-on-write by every packet
 
-  uint32_t m_sent; //!< Counter for sent packets
+  uint32_t m_sent; //!< Counter for sent packets, all sessions together
   uint32_t m_resent; //!< Counter for sent packets
-  Ptr<Socket> m_socket; //!< Socket
+  Ptr<Socket> m_socket; //!< IPv4 socket sending to the clients
+  Ptr<Socket> m_socket6; //!< IPv6 socket sending to the clients
   Ptr<Socket> r_socket; //!< Socket
   Address m_peerAddress; //!< Remote peer address
   uint16_t m_peerPort; //!< Remote peer port
   uint16_t m_recvPort; //!< Remote peer port
-  EventId m_sendEvent; //!< Event to send the next packet
+  EventId m_sendEvent; //!< Event to send the next frame
+  EventId m_pacingEvent; //!< Event to send the next paced packet
+  std::vector<Ptr<Packet> > m_batch; //!< Packets built by the current scheduling pass
+  std::vector<uint32_t> m_batchSessions; //!< Session index of every m_batch packet
+
+  /// Sessions added by AddSession before the application starts
+  std::vector<std::pair<Address, uint32_t> > m_initialSessions;
+  std::vector<Session> m_sessions; //!< all sessions, in scheduling order
+  std::map<Address, uint32_t> m_sessionIndex; //!< client socket address to m_sessions index
+  uint32_t m_maxSessions; //!< largest number of sessions
+  SchedulerMode m_scheduler; //!< how sessions share the sender
+  uint32_t m_nextSession; //!< session the next scheduling round starts with
+
+  FecScheme m_fecScheme; //!< FEC scheme protecting every frame
+  uint32_t m_fecParity; //!< Parity packets added to every frame
+  Ptr<FecCodec> m_codec; //!< Encoder of m_fecScheme, null for FEC_NONE
+  std::vector<uint8_t> m_parityData; //!< Parity payloads of m_parityFrame
+  std::vector<Ptr<Packet> > m_parityPayloads; //!< Parity packet templates of m_parityFrame
+  PendingFrame m_parityFrame; //!< Shape of the frame m_parityData was computed for
+  Ptr<Packet> m_parityFill; //!< m_payload m_parityData was computed from
+  uint32_t m_packetsPerFrame; //!< Packets making up one frame
+  uint32_t m_cacheFrames; //!< Number of recent frames NACKs can be answered for
+  std::string m_traceFile; //!< Frame size trace, empty for fixed-size frames
+  FrameSizeTrace m_trace; //!< Reader of m_traceFile
+  PacingMode m_pacing; //!< How the packets of a frame are sent
+  DataRate m_pacingRate; //!< Token bucket fill rate
+  uint32_t m_bucketSize; //!< Token bucket depth in bytes
   uint32_t seqNumber;
   uint32_t chkNumber;
   uint32_t lossNumber;
   uint32_t reNumber;
   uint32_t lastEchoNumber;
-  uint8_t send_state;
 
   /// Callbacks for tracing the packet Tx events
   TracedCallback<Ptr<const Packet> > m_txTrace;
@@ -193,6 +357,9 @@ private:
   /// Callbacks for tracing the packet Rx events, includes source and destination addresses
   TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
 
+  /// Callbacks for tracing receiver reports
+  TracedCallback<const Address &, const StreamingReportHeader &> m_reportTrace;
+
 };
 
 } // namespace ns3